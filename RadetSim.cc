@@ -21,6 +21,15 @@
 #include "GeneratorAction.hh"
 
 #include "Shielding.hh"
+#include "G4EmStandardPhysics.hh"
+#include "G4EmStandardPhysics_option1.hh"
+#include "G4EmStandardPhysics_option2.hh"
+#include "G4EmStandardPhysics_option3.hh"
+#include "G4EmStandardPhysics_option4.hh"
+#include "G4EmLivermorePhysics.hh"
+#include "G4EmPenelopePhysics.hh"
+#include "G4DecayPhysics.hh"
+#include "G4RadioactiveDecayPhysics.hh"
 
 #include "RunAction.hh"
 #include "EventAction.hh"
@@ -39,6 +48,22 @@
 #include "G4UIExecutive.hh"
 
 #include "G4HadronicParameters.hh"
+#include "G4GenericBiasingPhysics.hh"
+#include "G4StepLimiterPhysics.hh"
+#include "G4EmParameters.hh"
+#include "G4AdjointSimManager.hh"
+#include "G4OpticalPhysics.hh"
+
+#include "PhysicsTableCache.hh"
+#include "NavigationProfiler.hh"
+#include "AdjointPhysics.hh"
+#include "AdjointScorer.hh"
+#include "AdjointSteppingAction.hh"
+#include "AdjointEventAction.hh"
+#include "LightCollectionMap.hh"
+#include "OpticalMapGenerator.hh"
+#include "OpticalMapEventAction.hh"
+#include "OpticalMapSteppingAction.hh"
 
 #include <string>
 
@@ -48,6 +73,10 @@ using std::string;
 /// Basic usage of the program.
 void PrintUsage();
 
+/// Physics list by name: Shielding (default), EM_RDM (EM with decay and radioactive decay) or EM (EM only).
+/// Returns 0 for an unknown name.
+G4VModularPhysicsList* CreatePhysicsList( G4String name );
+
 string GetClassName(){ return "main"; }
 
 int main( int argc, char** argv ){
@@ -81,6 +110,13 @@ int main( int argc, char** argv ){
         }
     }
 
+    // The navigator for tracking is replaced before the run manager, whose stepping manager keeps it.
+    //
+    if( cmdl.Find("navProfile") ){
+        G4cout << GetClassName() << ": navigation is profiled per volume." << G4endl;
+        NavigationProfiler::Enable();
+    }
+
     G4cout << GetClassName() << ": Constructing RunManager..." << G4endl;
     G4RunManager * runManager = new G4RunManager();
 
@@ -90,6 +126,12 @@ int main( int argc, char** argv ){
     G4cout << GetClassName() << ": Constructing GeometryManager..." << G4endl;
     GeometryManager* geometryManager = GeometryManager::Get();
 
+    // Masses of volumes are cached on disk by geometry hash, since boolean solids take long to compute.
+    //
+    if( cmdl.Get("geometryCache")!="" ){
+        geometryManager->SetCacheDirectory( cmdl.Get("geometryCache") );
+    }
+
     G4cout << GetClassName() << ": Constructing GeometryConstruction..." << G4endl;
     GeometryConstruction* detectorConstruction = new GeometryConstruction( geometryManager );
 
@@ -98,15 +140,49 @@ int main( int argc, char** argv ){
 
 
     // Physics list
-    // For now, simply use the shielding physics list. This may be changed in the future for more customization.
+    // Shielding by default. Lighter lists without hadronic physics start much faster for gamma and beta studies.
     //
-    G4cout << GetClassName() << ": Constructing Shielding PhysicsList..." << G4endl;
-    G4VModularPhysicsList* physicsList = new Shielding;
+    G4String physicsName = cmdl.Get("physics");
+    if( physicsName=="" ){
+        physicsName = "Shielding";
+    }
+
+    G4cout << GetClassName() << ": Constructing " << physicsName << " PhysicsList..." << G4endl;
+    G4VModularPhysicsList* physicsList = CreatePhysicsList( physicsName );
+    if( physicsList==0 ){
+        G4cerr << GetClassName() << ": unknown physics list " << physicsName << G4endl;
+        PrintUsage();
+        return -2;
+    }
+
     G4HadronicParameters::Instance()->SetTimeThresholdForRadioactiveDecay( 1.0e+60*CLHEP::year );
         // Note: since 11.2. radioactive decay of very long half lives have been disabled
         // This needs to be turned on manually in C++ code or through macro by the following command
         // /process/had/rdm/thresholdForVeryLongDecayTime 1.0e+60 year
 
+    // EM option outside the regions with their own option (em key under regions in the geometry config).
+    // A fast option here and a precise one in the detector regions saves time in large passive volumes.
+    //
+    G4String emOption = cmdl.Get("em");
+    if( emOption!="" ){
+        G4VPhysicsConstructor* em = 0;
+        if( emOption=="opt0" )           em = new G4EmStandardPhysics();
+        else if( emOption=="opt1" )      em = new G4EmStandardPhysics_option1();
+        else if( emOption=="opt2" )      em = new G4EmStandardPhysics_option2();
+        else if( emOption=="opt3" )      em = new G4EmStandardPhysics_option3();
+        else if( emOption=="opt4" )      em = new G4EmStandardPhysics_option4();
+        else if( emOption=="livermore" ) em = new G4EmLivermorePhysics();
+        else if( emOption=="penelope" )  em = new G4EmPenelopePhysics();
+
+        if( em==0 ){
+            G4cerr << GetClassName() << ": unknown EM option " << emOption << ". Using the default of the physics list..." << G4endl;
+        }
+        else{
+            G4cout << GetClassName() << ": Replacing EM physics with " << em->GetPhysicsName() << "..." << G4endl;
+            physicsList->ReplacePhysics( em );
+        }
+    }
+
 /*
     // Configure geometry importance biasing
     G4GeometrySampler geom_sampler_gamma(detectorConstruction->GetWorldPhysical(),"gamma");
@@ -117,6 +193,48 @@ int main( int argc, char** argv ){
     physicsList->RegisterPhysics( new G4ImportanceBiasing(&geom_sampler_ep) );
 */
 
+    // Step limiter and special cuts for the user limits of regions in the geometry config.
+    // Registered always since the config is loaded by macro; the processes do nothing in volumes without limits.
+    //
+    physicsList->RegisterPhysics( new G4StepLimiterPhysics() );
+
+    // Generic biasing for forced collision in thin active volumes.
+    // The physics is wrapped only when requested since the volumes to bias are read from the geometry config
+    // and the operators are attached in GeometryConstruction::ConstructSDandField.
+    //
+    if( cmdl.Find("bias")==true ){
+        G4cout << GetClassName() << ": Registering generic biasing physics for gamma..." << G4endl;
+        G4GenericBiasingPhysics* biasingPhysics = new G4GenericBiasingPhysics();
+        biasingPhysics->Bias("gamma");
+        physicsList->RegisterPhysics( biasingPhysics );
+    }
+
+    // Reverse Monte Carlo for small detectors in large extended sources.
+    // Adjoint models need the direct gamma processes, so the general gamma process is disabled.
+    //
+    bool adjoint = cmdl.Find("adjoint");
+    if( adjoint==true ){
+        G4cout << GetClassName() << ": Registering adjoint physics..." << G4endl;
+        G4EmParameters::Instance()->SetGeneralProcessActive( false );
+        physicsList->RegisterPhysics( new AdjointPhysics() );
+    }
+
+    // Optical photons are tracked only to generate the light collection map.
+    //
+    G4String opticalMapName = cmdl.Get("opticalMap");
+    if( opticalMapName!="" ){
+        G4cout << GetClassName() << ": Registering optical physics for the light collection map..." << G4endl;
+        physicsList->RegisterPhysics( new G4OpticalPhysics() );
+    }
+
+    // Physics tables are cached in the given directory, keyed by physics, cuts and materials.
+    //
+    G4String tableCache = cmdl.Get("tableCache");
+    if( tableCache!="" ){
+        G4String physicsKey = physicsName + " em=" + emOption + ( cmdl.Find("bias") ? " bias" : "" ) + ( adjoint ? " adjoint" : "" ) + ( opticalMapName!="" ? " optical" : "" );
+        PhysicsTableCache::Get()->SetDirectory( tableCache, physicsKey );
+    }
+
     // Note below line has to be after setting up biasing.
     G4cout << GetClassName() << ": Setting PhysicsList User Initialization..." << G4endl;
     runManager->SetUserInitialization( physicsList );
@@ -149,21 +267,50 @@ int main( int argc, char** argv ){
     runManager->SetUserAction( eventAction );
 
 
+    // In adjoint mode, run is started with /adjoint/start_run and G4AdjointSimManager swaps in these actions.
+    // Step-level recording of the forward mode is not used.
+    //
+    if( adjoint==true ){
+        AdjointScorer* adjointScorer = new AdjointScorer();
+        runAction->SetAdjointScorer( adjointScorer );
+
+        G4AdjointSimManager* adjointManager = G4AdjointSimManager::GetInstance();
+        adjointManager->SetAdjointRunAction( runAction );
+        adjointManager->SetAdjointEventAction( new AdjointEventAction( adjointScorer ) );
+        adjointManager->SetAdjointSteppingAction( new AdjointSteppingAction( adjointScorer ) );
+    }
+
     // Tracking, stepping and stacking action
     // Enable them only when output is needed.
     // This is checked using RunAction's output filename since TTree and TTile are initialized afterwards.
     //
     //if( runAction->GetOutputFileName()!="" ){
-    G4cout << GetClassName() << ": Constructing and setting TrackingAction..." << G4endl;
-    runManager->SetUserAction( new TrackingAction( runAction, eventAction ) );
+    if( adjoint==false && opticalMapName=="" ){
+        G4cout << GetClassName() << ": Constructing and setting TrackingAction..." << G4endl;
+        runManager->SetUserAction( new TrackingAction( runAction, eventAction ) );
     
-    G4cout << GetClassName() << ": Constructing and setting SteppingAction..." << G4endl;
-    runManager->SetUserAction( new SteppingAction( runAction, eventAction ) );
+        G4cout << GetClassName() << ": Constructing and setting SteppingAction..." << G4endl;
+        runManager->SetUserAction( new SteppingAction( runAction, eventAction ) );
     
-    G4cout << GetClassName() << ": Constructing and setting StackingAction..." << G4endl;
-    runManager->SetUserAction( new StackingAction( runAction, eventAction ) );
+        G4cout << GetClassName() << ": Constructing and setting StackingAction..." << G4endl;
+        runManager->SetUserAction( new StackingAction( runAction, eventAction ) );
+    }
     //}
 
+    // In the light collection map mode, each event is a burst of optical photons in the crystal
+    // and photons reaching the photocathode are counted instead of recording steps.
+    // The map is written to the file given by --opticalMap at the end of each run.
+    //
+    if( opticalMapName!="" ){
+        G4cout << GetClassName() << ": Setting actions for the light collection map..." << G4endl;
+        LightCollectionMap* lightMap = new LightCollectionMap( opticalMapName );
+        runAction->SetLightCollectionMap( lightMap );
+
+        runManager->SetUserAction( new OpticalMapGenerator( lightMap ) );
+        runManager->SetUserAction( new OpticalMapEventAction( lightMap ) );
+        runManager->SetUserAction( new OpticalMapSteppingAction( lightMap ) );
+    }
+
     //runManager->Initialize();
     //  this line should be called within the macro
     //  so that user can pass geometry parameters inside
@@ -233,12 +380,45 @@ int main( int argc, char** argv ){
 }
 
 
+G4VModularPhysicsList* CreatePhysicsList( G4String name ){
+
+    if( name=="Shielding" ){
+        return new Shielding;
+    }
+
+    if( name!="EM_RDM" && name!="EM" ){
+        return 0;
+    }
+
+    G4VModularPhysicsList* physicsList = new G4VModularPhysicsList();
+    physicsList->SetDefaultCutValue( 0.7*CLHEP::mm );
+        // same as Shielding
+
+    physicsList->RegisterPhysics( new G4EmStandardPhysics() );
+
+    if( name=="EM_RDM" ){
+        physicsList->RegisterPhysics( new G4DecayPhysics() );
+        physicsList->RegisterPhysics( new G4RadioactiveDecayPhysics() );
+    }
+
+    return physicsList;
+}
+
+
 void PrintUsage() {
     G4cerr << "\nUsage: executable [-option [argument(s)] ]" << G4endl;
     G4cerr << "\t-m/--macro,       used to specify the macro file to execute.\n";
     G4cerr << "\t-u/--interactive, enter interactive session. If -m/--macro is specified, macro is executed before init_vis.mac\n";
     G4cerr << "\t-v,--vis,         enable visualization. (disabled by default)\n";
     G4cerr << "\t--seed,           the random seed to be used. (default current time)\n";
+    G4cerr << "\t--bias,           enable forced-collision biasing for volumes listed under biasing/forceCollision in the geometry config.\n";
+    G4cerr << "\t--physics,        physics list: Shielding (default), EM_RDM (EM and radioactive decay) or EM (EM only).\n";
+    G4cerr << "\t--em,             EM physics outside regions with their own option: opt0 (default), opt1, opt2, opt3, opt4, livermore or penelope.\n";
+    G4cerr << "\t--geometryCache,  directory of cached volume masses, shared by jobs with the same geometry.\n";
+    G4cerr << "\t--navProfile,     count and time navigation per volume, written to the navigation macro of the output.\n";
+    G4cerr << "\t--tableCache,     directory of cached physics tables, shared by jobs with the same physics, cuts and materials.\n";
+    G4cerr << "\t--adjoint,        reverse Monte Carlo mode. Run with /adjoint/start_run; scores are configured under adjoint in the geometry config.\n";
+    G4cerr << "\t--opticalMap,     generate the light collection map of the crystal by tracking optical photons and write it to the given file.\n";
     G4cerr << "\t-o/--output,      specify the output file name to which trajectories will be recorded.\n";
     G4cerr << G4endl;
 }
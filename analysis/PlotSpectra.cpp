@@ -21,6 +21,7 @@
 //      --veto VolName Threshold (can be multiple veto volumes)
 //      --color C1 [integer using ROOT code scheme]
 //      --style S1 [integer using ROOT code scheme]
+//      --source Code1 [only events with this source code, e.g. PDG code of an isotope in a mixed source]
 
 // Key option --title is used to separate multiple curves.
 // After each title keyword, --add can be used to add multiple subcomponent.
@@ -76,6 +77,7 @@ struct Spectrum{
         style = 1;
         color = 1;
         width = 2;
+        source = 0;
     }
 
     string title;
@@ -84,6 +86,9 @@ struct Spectrum{
     int color;
     int width;
 
+    int source;
+        // if non-zero, only events generated by this source are filled.
+
     void AddVetoVolume( string vol, double threshold){
         vetoInfo[vol] = threshold;
     }
@@ -112,7 +117,7 @@ struct Spectrum{
 
 // Fill histogram from another ROOT tree.
 //
-void FillHistFromTree( TH1F* hist, string rootName, string voi, map<string, double> vetoInfo );
+void FillHistFromTree( TH1F* hist, string rootName, string voi, map<string, double> vetoInfo, int source );
 
 
 int main( int argc, char* argv[]){
@@ -192,6 +197,8 @@ int main( int argc, char* argv[]){
                     temp.style = atoi( argv[++i] );
                 else if( string(argv[i])=="--width" )
                     temp.width = atoi( argv[++i] );
+                else if( string(argv[i])=="--source" )
+                    temp.source = atoi( argv[++i] );
                 else if( string(argv[i])=="--veto" ){
                     string vol = string( argv[++i] );
                     double threshold = atof( argv[++i] );
@@ -254,7 +261,7 @@ int main( int argc, char* argv[]){
 
                 cout << "\tadding " << *k << endl;
 
-                FillHistFromTree( &temp, *k, voi, i->vetoInfo );
+                FillHistFromTree( &temp, *k, voi, i->vetoInfo, i->source );
 
                 TMacro mac_duration = GetMacro( *k, "duration" );
                 duration = GetFloat( mac_duration );
@@ -306,7 +313,7 @@ int main( int argc, char* argv[]){
 }
 
 
-void FillHistFromTree( TH1F* hist, string rootName, string voi, map<string, double> vetoInfo ){
+void FillHistFromTree( TH1F* hist, string rootName, string voi, map<string, double> vetoInfo, int source ){
 
     //cout << "\t\tFilling histogram from tree" << endl;
 
@@ -326,6 +333,19 @@ void FillHistFromTree( TH1F* hist, string rootName, string voi, map<string, doub
     string plotVar = string( "edep_" ) + voi;
     tree->SetBranchAddress( plotVar.c_str(), &energy);
 
+    // Source code is used to split a mixed source into its components.
+    //
+    int sourceVar = 0;
+    if( source!=0 ){
+        if( tree->GetBranch( "source" )==0 ){
+            cerr << "\t\tNo source branch in " << rootName << ". Source selection ignored." << endl;
+            source = 0;
+        }
+        else{
+            tree->SetBranchAddress( "source", &sourceVar );
+        }
+    }
+
     // Some information for vetoes
     // volName stores names of the active veto volumes.
     // thresholds stores the corresponding thresholds.
@@ -367,7 +387,7 @@ void FillHistFromTree( TH1F* hist, string rootName, string voi, map<string, doub
 
         // An arbitrary energy threshold so that 0 is not filled.
         //
-        if( energy>1e-6 ){
+        if( energy>1e-6 && ( source==0 || sourceVar==source ) ){
 
             fill = true;
 
@@ -467,6 +487,7 @@ void PrintUsage( string name ){
     cout << "Usage: " << name << " --hist Nbins Min Max --voi VolOfInterest [--veto VetoVol1 threshold1] --title Title1 --add Act1/Flux1 foo1.root bar1.root [--add foo2.root bar2.root] [--color N --style N --width N]" << endl;
     cout << "\t Use --title to specify multiple curves onto the same plot. Files specified after each --add will be added to the curve specified with the preceding --title.\n";
     cout << "\t Activity/flux in the unit of Bq/kg and No./m2/s, respectively.\n";
+    cout << "\t --source selects events by source code, e.g. PDG code of an isotope written by /generator/addIsotope.\n";
     cout << "\t --color, --style and --width are used to specify optional line color and line style using ROOT code scheme.\n";
     cout << "\t One can optionally specify multiple veto volumes with different thresholds. Threshold is in keV.\n";
 }
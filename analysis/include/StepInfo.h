@@ -21,6 +21,9 @@ struct StepInfo{
     double Ekf;
     double Edep;
     double time;
+
+    int source;
+        // source code of the event (e.g. PDG code of the isotope), 0 if not recorded.
 };
 
 #endif
@@ -79,6 +79,12 @@ public:
     //
     double GetTimeSimulated( TMacro run, TMacro geo );
 
+    double GetSurfaceArea( string fileName );
+        // area in m2 from the surfaceSource macro, -1 if the file was not produced by /generator/surface.
+
+    double GetCounter( string fileName, string name );
+        // value from the counters macro, 0 if not found.
+
     // Return whether parent info should be recorded in the output
     //
     bool GetParentInfo(){ return parentInfo; }
@@ -143,6 +149,8 @@ private:
         // global ID of the event processed
     unsigned int eventID;
         // event ID in its own run.
+    int source;
+        // source code written by the generator, e.g. PDG code of the isotope in a mixed source.
     unsigned int clusterIndex;
         // index of the event cluster when multiple event occurred in the DAQ window.
     double timeStamp;
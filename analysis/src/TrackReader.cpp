@@ -4,6 +4,7 @@
 #include "TTree.h"
 #include "TFile.h"
 #include "TObjString.h"
+#include "TMacro.h"
 //#include "TKey.h"
 
 #include <iostream>
@@ -33,6 +34,10 @@ void TrackReader::ConfigureTTree( TTree* tree ){
     tree->Branch( "eventID", &eventID, "eventID/I");
     tree->Branch( "clusterIndex", &clusterIndex, "clusterIndex/I");
 
+    source = 0;
+    tree->Branch( "source", &source, "source/I");
+        // 0 if the input file does not have source information.
+
     timeStamp = -1;
     tree->Branch( "timeStamp", &timeStamp, "timeStamp/D" );
         // Time stamp is by default -1.
@@ -202,7 +207,26 @@ void TrackReader::Process( string outputStr, vector<string> inputStr ){
             gTab = mac2;
         }
 
-        Tsimulated += GetTimeSimulated( mac1, mac2 );
+        // Events generated from split decay stages are not primaries.
+        // Stages still queued at the end of a run were counted when split but never generated.
+        //
+        double Nevents = GetNbParticleSimulated( mac1 );
+        double Nstages = GetCounter( *itr, "splitStages" ) - GetCounter( *itr, "splitStagesDropped" );
+        double fraction = ( Nevents>0 && Nstages>0 ) ? ( Nevents-Nstages )/Nevents : 1;
+        if( Nstages>0 ){
+            cout << Nstages << " events are split decay stages" << endl;
+        }
+
+        // Files from the native surface source carry the area; older files are normalized from the macro text.
+        //
+        double area = GetSurfaceArea( *itr );
+        if( area>0 ){
+            cout << "Surface source area is " << area << " m2" << endl;
+            Tsimulated += fraction * Nevents / area;
+        }
+        else{
+            Tsimulated += fraction * GetTimeSimulated( mac1, mac2 );
+        }
     }
 
     outputFile->cd();
@@ -265,6 +289,11 @@ void TrackReader::ProcessFile( TTree* tree, string input ){
     inputTree -> SetBranchAddress( "t",        &rdata.time);
     inputTree -> SetBranchAddress( "process",  &rdata.processName);
 
+    rdata.source = 0;
+    if( inputTree->GetBranch( "source" )!=0 ){
+        inputTree -> SetBranchAddress( "source", &rdata.source);
+    }
+
     // ==================================================
     // Loop over the tree and process the events.
     // ==================================================
@@ -320,6 +349,7 @@ void TrackReader::ProcessFile( TTree* tree, string input ){
         else{
 
             eventID = rdata.eventID;
+            source = rdata.source;
             //cout << "EventID: " << eventID << ", parentID: " << rdata.trackID << endl;
 
             // Suerfu on June 20, 2023: set parent information if not set yet.
@@ -546,8 +576,45 @@ double TrackReader::GetTimeSimulated( TMacro runMacro, TMacro geoMacro ){
     string keyword1( "/generator/wall" );
     string keyword2( "/confine" );
     string keyword3( "/generator/setMaterial" );
+    string keyword4( "/generator/addIsotope" );
+
+    // Mixed source: activities are absolute, so the result is the live time in seconds
+    // and the spectrum should be added with activity 1.
+    //
+    if( runMacro.GetLineWith( keyword4.c_str() ) != 0 ){
 
-    if( runMacro.GetLineWith( keyword1.c_str() ) != 0 ){
+        double rate = 0;
+
+        TIter next( runMacro.GetListOfLines() );
+        TObject* obj;
+        while( (obj=next()) ){
+
+            string line( obj->GetName() );
+            if( line.compare( 0, keyword4.size(), keyword4 )!=0 ){
+                continue;
+            }
+
+            string foo, isotope, target;
+            double activity = 0;
+            stringstream ss( line );
+            ss >> foo >> isotope >> activity >> target;
+
+            double mass = GetMassByMaterial( geoMacro, target );
+            if( mass<=0 ){
+                mass = GetMassByName( geoMacro, target );
+            }
+            cout << isotope << " " << activity << " Bq/kg in " << target << " " << mass << " kg" << endl;
+
+            rate += activity * mass;
+        }
+
+        if( rate<=0 ){
+            return -1;
+        }
+        return NbParticle / rate;
+    }
+
+    else if( runMacro.GetLineWith( keyword1.c_str() ) != 0 ){
 
         string target( runMacro.GetLineWith( keyword1.c_str() )->String().Data() );
 
@@ -627,6 +694,56 @@ double TrackReader::GetTimeSimulated( TMacro runMacro, TMacro geoMacro ){
 }
 
 
+double TrackReader::GetSurfaceArea( string fileName ){
+
+    double area = -1;
+
+    TFile* file = TFile::Open( fileName.c_str(), "READ");
+    if( !file ){
+        return area;
+    }
+
+    TMacro* mac = (TMacro*)file->Get( "surfaceSource" );
+    if( mac!=0 && mac->GetLineWith( "area " )!=0 ){
+        string foo;
+        stringstream ss( mac->GetLineWith( "area " )->String().Data() );
+        ss >> foo >> area;
+    }
+
+    file->Close();
+    return area;
+}
+
+
+double TrackReader::GetCounter( string fileName, string name ){
+
+    double value = 0;
+
+    TFile* file = TFile::Open( fileName.c_str(), "READ");
+    if( !file ){
+        return value;
+    }
+
+    TMacro* mac = (TMacro*)file->Get( "counters" );
+    if( mac!=0 ){
+        TIter next( mac->GetListOfLines() );
+        TObject* obj;
+        while( (obj=next()) ){
+            string key;
+            double n = 0;
+            stringstream ss( obj->GetName() );
+            ss >> key >> n;
+            if( key==name ){
+                value = n;
+            }
+        }
+    }
+
+    file->Close();
+    return value;
+}
+
+
 unsigned int TrackReader::GetMaxFileLength( vector<string> inputs ){
 
     unsigned int max_size = 0;
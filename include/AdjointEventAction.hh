@@ -0,0 +1,29 @@
+/// \file AdjointEventAction.hh
+/// \brief Definition of the AdjointEventAction class
+
+#ifndef ADJOINTEVENTACTION_H
+#define ADJOINTEVENTACTION_H 1
+
+#include "G4UserEventAction.hh"
+
+#include "AdjointScorer.hh"
+
+
+/// Event action used by G4AdjointSimManager. Scores of each adjoint event are written as one entry.
+//
+class AdjointEventAction : public G4UserEventAction{
+
+public:
+
+    AdjointEventAction( AdjointScorer* scorer ) : G4UserEventAction(), fScorer( scorer ) {}
+
+    virtual ~AdjointEventAction(){}
+
+    virtual void EndOfEventAction( const G4Event* event ){ fScorer->Fill( event ); }
+
+private:
+
+    AdjointScorer* fScorer;
+};
+
+#endif
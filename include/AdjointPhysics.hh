@@ -0,0 +1,33 @@
+/// \file AdjointPhysics.hh
+/// \brief Definition of the AdjointPhysics class
+
+#ifndef ADJOINTPHYSICS_H
+#define ADJOINTPHYSICS_H 1
+
+#include "G4VPhysicsConstructor.hh"
+#include "globals.hh"
+
+
+/// Reverse electromagnetic processes for adjoint gamma and electron.
+///
+/// Adjoint models use the cross sections of the direct gamma and e- processes
+/// (compt, phot, eIoni, eBrem) registered by the forward physics list,
+/// so this constructor must be registered after the EM physics.
+/// Gamma general process must be disabled so that the direct processes can be found.
+//
+class AdjointPhysics : public G4VPhysicsConstructor{
+
+public:
+
+    AdjointPhysics( const G4String& name = "Adjoint" );
+
+    virtual ~AdjointPhysics(){}
+
+    virtual void ConstructParticle();
+
+    virtual void ConstructProcess();
+
+    G4String GetClassName(){ return "AdjointPhysics"; }
+};
+
+#endif
@@ -0,0 +1,90 @@
+/// \file AdjointScorer.hh
+/// \brief Definition of the AdjointScorer class
+
+#ifndef ADJOINTSCORER_H
+#define ADJOINTSCORER_H 1
+
+#include "globals.hh"
+
+#include "TTree.h"
+
+#include <vector>
+
+class G4Step;
+class G4Event;
+
+
+/// Track-length estimator of the adjoint gamma flux in source materials.
+///
+/// Adjoint gammas start on the detector (/adjoint/DefineAdjSourceOnTheExtSurfaceOfAVolume)
+/// and are tracked back towards the sources. For each source material and gamma line,
+/// weight x track length of adjoint gammas whose energy is within the line window is accumulated
+/// and divided by the window width.
+/// For a uniform isotropic emission density S (gamma/cm3/s) of a line in a material,
+/// the count rate of detector energy Eadj is S x score / N summed over events with that Eadj,
+/// where N is the number of adjoint events of the run. S is computed from the activity (Bq/kg) of
+/// the parent of each line, the intensity of the line and the density of the material, and
+/// S x score is stored as rate, so that the sum of rate / N is the count rate of each (material, line).
+/// The volume of the source is implicit in the track length and needs not be given.
+///
+/// Materials, lines (keV), intensities, activities and relative half-width of the window are read from the geometry config:
+///     adjoint {
+///         materials : Rock SS304,
+///         lines : 609.3 1460.8 2614.5,
+///         intensities : 0.455 0.1066 0.356,
+///         window : 0.01,
+///         activity {
+///             Rock : 30 300 30,
+///             SS304 : 0.01 0 0.01,
+///         }
+///     }
+//
+class AdjointScorer{
+
+public:
+
+    AdjointScorer();
+
+    ~AdjointScorer(){}
+
+    void Configure();
+        // reads the config. Called at the beginning of run when geometry config has been loaded.
+
+    void Branch( TTree* tree );
+
+    std::vector<G4String> GetSummary();
+        // materials, lines and the index of each (material, line) in the score array
+
+    void Score( const G4Step* step );
+
+    void Fill( const G4Event* event );
+        // fills the tree and resets the scores
+
+private:
+
+    TTree* tree;
+
+    std::vector<G4String> materials;
+    std::vector<G4double> lines;
+        // in keV
+
+    G4double window;
+
+    G4double Eadj;
+        // energy of the adjoint primary in keV, i.e. energy at the detector
+    G4double weight;
+        // weight of the adjoint primary
+
+    std::vector<G4double> score;
+        // index: material x Nlines + line, in cm/keV
+
+    std::vector<G4double> emission;
+        // emission density S of each (material, line) in gamma/cm3/s, 0 if no activity is given
+
+    std::vector<G4double> rate;
+        // S x score of each (material, line)
+
+    G4int nScore;
+};
+
+#endif
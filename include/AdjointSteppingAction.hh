@@ -0,0 +1,30 @@
+/// \file AdjointSteppingAction.hh
+/// \brief Definition of the AdjointSteppingAction class
+
+#ifndef ADJOINTSTEPPINGACTION_H
+#define ADJOINTSTEPPINGACTION_H 1
+
+#include "G4UserSteppingAction.hh"
+
+#include "AdjointScorer.hh"
+
+
+/// Stepping action used by G4AdjointSimManager during adjoint tracking.
+/// Steps are passed to the AdjointScorer instead of being recorded.
+//
+class AdjointSteppingAction : public G4UserSteppingAction{
+
+public:
+
+    AdjointSteppingAction( AdjointScorer* scorer ) : G4UserSteppingAction(), fScorer( scorer ) {}
+
+    virtual ~AdjointSteppingAction(){}
+
+    virtual void UserSteppingAction( const G4Step* step ){ fScorer->Score( step ); }
+
+private:
+
+    AdjointScorer* fScorer;
+};
+
+#endif
@@ -0,0 +1,49 @@
+/// \file AliasTable.hh
+/// \brief Definition of the AliasTable class
+
+#ifndef ALIASTABLE_H
+#define ALIASTABLE_H 1
+
+#include "globals.hh"
+
+#include <vector>
+
+
+/// Walker's alias table for sampling a discrete distribution in constant time.
+/// The table is built once from non-negative weights. Each sample costs one random number.
+//
+class AliasTable{
+
+public:
+
+    AliasTable();
+
+    ~AliasTable(){}
+
+    void Build( const std::vector<G4double>& weights );
+        // build the table from weights. Weights need not be normalized.
+
+    size_t Sample() const;
+        // returns the index of the sampled entry.
+
+    size_t size() const { return probability.size(); }
+
+    bool empty() const { return probability.empty(); }
+
+    G4double GetTotal() const { return total; }
+        // sum of the weights used to build the table.
+
+    void Clear();
+
+private:
+
+    std::vector<G4double> probability;
+        // probability of keeping the entry
+
+    std::vector<size_t> alias;
+        // entry to pick otherwise
+
+    G4double total;
+};
+
+#endif
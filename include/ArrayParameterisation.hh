@@ -0,0 +1,43 @@
+/// \file ArrayParameterisation.hh
+/// \brief Definition of the ArrayParameterisation class
+
+#ifndef ARRAYPARAMETERISATION_H
+#define ARRAYPARAMETERISATION_H 1
+
+#include "G4VPVParameterisation.hh"
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
+
+class G4VPhysicalVolume;
+
+
+/// Places copies of one volume on a regular nx x ny x nz grid.
+/// Copy number n is at ix = n % nx, iy = (n / nx) % ny, iz = n / (nx ny), and the grid is centred on centre.
+//
+class ArrayParameterisation : public G4VPVParameterisation{
+
+public:
+
+    ArrayParameterisation( G4int nx, G4int ny, G4int nz, G4ThreeVector pitch, G4ThreeVector centre, G4RotationMatrix* rot );
+
+    virtual ~ArrayParameterisation(){}
+
+    virtual void ComputeTransformation( const G4int copyNo, G4VPhysicalVolume* physVol ) const;
+
+    G4int GetNumberOfCopies() const { return fN[0]*fN[1]*fN[2]; }
+
+    G4ThreeVector GetPosition( G4int copyNo ) const;
+
+private:
+
+    G4int fN[3];
+
+    G4ThreeVector fPitch;
+
+    G4ThreeVector fCentre;
+
+    G4RotationMatrix* fRotation;
+};
+
+
+#endif
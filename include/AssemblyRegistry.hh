@@ -0,0 +1,80 @@
+/// \file AssemblyRegistry.hh
+/// \brief Definition of the AssemblyRegistry class
+
+#ifndef ASSEMBLYREGISTRY_H
+#define ASSEMBLYREGISTRY_H 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
+
+#include <map>
+#include <functional>
+
+class G4LogicalVolume;
+class G4VPhysicalVolume;
+
+
+/// Singleton class.
+/// Detector assemblies (e.g. the NaI crystal - PMT assembly) are registered with a function that builds their
+/// logical volume. Each assembly is built once per geometry construction and all placements share its logical
+/// volume, so that solids, logical volumes and navigation voxels do not grow with the number of copies.
+///
+/// Regular arrays are placed either as individual placements, as one G4PVParameterised, or as nested
+/// G4PVReplica slices along x, y and z of a container filled with the mother material.
+//
+class AssemblyRegistry{
+
+private:
+
+    AssemblyRegistry(){}
+
+    ~AssemblyRegistry(){}
+
+    static AssemblyRegistry* registry;
+
+public:
+
+    static AssemblyRegistry* Get();
+
+    void Register( G4String name, std::function< G4LogicalVolume*() > builder );
+        // A later registration with the same name replaces the builder.
+
+    void Unregister( G4String name );
+        // Called by owners of builders that refer to themselves, before they are destroyed.
+
+    bool Find( G4String name ){ return builders.find( name )!=builders.end(); }
+
+    G4LogicalVolume* GetLogicalVolume( G4String name );
+        // Builds the assembly on first use, returns 0 if the name is not registered.
+
+    G4VPhysicalVolume* Place( G4String name, G4LogicalVolume* mother, G4ThreeVector pos, G4RotationMatrix* rot, G4bool checkOverlaps, G4String pvName = "" );
+        // Places the assembly with the next copy number, counted from 0 for each assembly.
+        // The physical volume is named after the assembly unless pvName is given.
+
+    G4VPhysicalVolume* PlaceArray( G4LogicalVolume* lv, G4String name, G4LogicalVolume* mother,
+                                   G4int nx, G4int ny, G4int nz, G4ThreeVector pitch, G4ThreeVector centre,
+                                   G4RotationMatrix* rot, G4String mode, G4bool checkOverlaps );
+        // Places nx x ny x nz copies of lv centred on centre with mode placement, parameterised or replica.
+        // Copy n is at ix = n % nx, iy = (n / nx) % ny, iz = n / (nx ny) for placement and parameterised.
+        // With replica, the copy number of the volume is 0 and the indices are the replica numbers of the
+        // three levels above it (z, y and x). A pitch of 0 along an axis uses the extent of lv.
+        // rot rotates each copy in place, except with replica where it rotates the whole array.
+        // Returns the first placement, the parameterised volume or the container.
+
+    void Clear();
+        // Forgets built assemblies. Called when the geometry is constructed again, since the stores are cleaned.
+
+    G4String GetClassName(){ return "AssemblyRegistry"; }
+
+private:
+
+    std::map< G4String, std::function< G4LogicalVolume*() > > builders;
+
+    std::map< G4String, G4LogicalVolume* > volumes;
+
+    std::map< G4String, G4int > copies;
+};
+
+
+#endif
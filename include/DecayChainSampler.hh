@@ -0,0 +1,73 @@
+/// \file DecayChainSampler.hh
+/// \brief Definition of the DecayChainSampler class
+
+#ifndef DECAYCHAINSAMPLER_H
+#define DECAYCHAINSAMPLER_H 1
+
+#include "globals.hh"
+#include "G4ParticleDefinition.hh"
+
+#include "AliasTable.hh"
+
+#include <vector>
+
+class G4RadioactiveDecay;
+
+
+/// Samples one member of a radioactive decay chain in secular equilibrium.
+///
+/// The chain is expanded once from the decay tables of G4RadioactiveDecay.
+/// The activity of each member relative to the top of the chain is the product of branching ratios leading to it.
+/// Excited daughters (including isomers) belong to the decay that produced them.
+/// Ground-state daughters are new members; they must be killed during tracking (see StackingAction)
+/// so that each event contains exactly one member decay.
+//
+class DecayChainSampler{
+
+public:
+
+    DecayChainSampler();
+
+    ~DecayChainSampler(){}
+
+    bool Build( G4String isotope );
+        // isotope is specified as element symbol + mass number, e.g. U238, Th232, K40.
+        // Must be called after /run/initialize since decay tables are obtained from the process.
+
+    static G4ParticleDefinition* GetIon( G4String isotope );
+        // ground state of e.g. U238, or 0 if the name cannot be interpreted.
+
+    void SetEmittersOnly( bool a );
+        // if true, only members emitting gamma or beta are sampled.
+
+    bool empty(){ return table.empty(); }
+
+    G4ParticleDefinition* Sample();
+
+    G4double GetWeight(){ return table.GetTotal(); }
+        // number of member decays per decay of the top of the chain, summed over sampled members.
+
+    std::vector<G4String> GetSummary();
+        // one line per member: name, PDG code, relative activity, gamma flag, beta flag
+
+private:
+
+    G4RadioactiveDecay* decay;
+
+    std::vector<G4ParticleDefinition*> members;
+    std::vector<G4double> activity;
+    std::vector<bool> gammaEmitter;
+    std::vector<bool> betaEmitter;
+
+    bool emittersOnly;
+
+    AliasTable table;
+
+    void Walk( G4ParticleDefinition* nucleus, G4double fraction, G4int member, G4int depth );
+
+    G4int AddMember( G4ParticleDefinition* nucleus, G4double fraction );
+
+    void BuildTable();
+};
+
+#endif
@@ -0,0 +1,39 @@
+/// \file DeferredStage.hh
+/// \brief Definition of the DeferredStage structure
+
+#ifndef DEFERREDSTAGE_H
+#define DEFERREDSTAGE_H 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+class G4ParticleDefinition;
+
+
+/// Products of a delayed radioactive decay, taken out of an event to be simulated as a separate event.
+/// Times are relative to the decay.
+//
+struct DeferredStage{
+
+    struct Track{
+        G4ParticleDefinition* definition;
+        G4ThreeVector position;
+        G4ThreeVector direction;
+        G4double energy;
+        G4double time;
+        G4double weight;
+    };
+
+    G4int parentEventID;
+        // ID of the event in which the decay chain started
+
+    G4int sourceCode;
+    G4double sourceWeight;
+        // copied from the EventInformation of the parent event
+
+    std::vector<Track> tracks;
+};
+
+#endif
@@ -0,0 +1,77 @@
+/// \file EarlyAbort.hh
+/// \brief Definition of the EarlyAbort class
+
+#ifndef EARLYABORT_H
+#define EARLYABORT_H 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <set>
+#include <map>
+#include <vector>
+
+class G4Track;
+class G4ParticleDefinition;
+class G4MaterialCutsCouple;
+
+#include "G4TrackVector.hh"
+#include "TargetBoxes.hh"
+
+
+/// Aborts an event once no live track can reach a recordWhenHit volume.
+///
+/// A track may reach the target unless it is a stable, charged particle (e-, proton, stable nucleus)
+/// whose residual range from the energy-loss tables is shorter than its distance to the bounding box of the nearest target,
+/// Neutral particles, positrons, unstable particles and unstable nuclei are always assumed to reach the target.
+/// Bremsstrahlung of the slowing-down electrons is neglected.
+/// The number of such tracks in the event (tracked or stacked) is kept; when it drops to zero
+/// before any target has been hit, the event cannot be recorded and is aborted.
+/// Targets are the axis-aligned global bounding boxes of each placement, including rotations of the volumes and their mothers.
+//
+class EarlyAbort{
+
+public:
+
+    EarlyAbort(){ targets = 0; }
+
+    ~EarlyAbort(){}
+
+    void SetTargets( TargetBoxes* a ){ targets = a; }
+        // bounding boxes of the recordWhenHit volumes, owned by RunAction.
+
+    void BeginOfEvent();
+
+    void NewTrack( const G4Track* track );
+        // called when the track is stacked, i.e. it is live until it ends.
+
+    void ForgetTrack( const G4Track* track );
+        // called when a stacked track is removed without being tracked.
+
+    void Step( const G4Track* track, bool hit );
+        // updates the current track; hit is true if the step is in a target volume.
+
+    bool EndOfTrack( const G4Track* track, const G4TrackVector* secondaries );
+        // returns true if the event should be aborted.
+        // secondaries of the track are not stacked yet and are checked here.
+
+private:
+
+    TargetBoxes* targets;
+
+    bool MayReach( const G4Track* track, const G4MaterialCutsCouple* couple );
+
+    const G4MaterialCutsCouple* GetCouple( const G4Track* track );
+
+    bool RangeChecked( const G4ParticleDefinition* def );
+        // true for particles whose fate is decided by the range: charged and without finite lifetime
+
+    std::map<G4int, bool> reachable;
+        // track ID and whether it was counted as able to reach a target
+
+    G4int nReachable;
+
+    bool targetHit;
+};
+
+#endif
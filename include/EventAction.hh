@@ -64,6 +64,7 @@ private:
     G4String tmp_nextVolumeName;
     G4String tmp_processName;
     
+    int runID;
     int eventID;
     int trackID;
     int parentID;
@@ -72,8 +73,16 @@ private:
     double rx, ry, rz;
     double px, py, pz;
     double Eki, Ekf, Edep;
+    double Wi, Wf;
     double globalTime;
 
+    int Npe;
+
+    int sourceCode;
+    double sourceWeight;
+    int parentEventID;
+        // per-event information from EventInformation
+
     void SetFillValue( StepInfo& wStep){
 
         eventID = wStep.GetEventID();
@@ -103,7 +112,12 @@ private:
         Ekf = wStep.GetEkf()/CLHEP::keV;
         Edep = wStep.GetEdep()/CLHEP::keV;
 
+        Wi = wStep.GetWi();
+        Wf = wStep.GetWf();
+
         globalTime = wStep.GetGlobalTime()/CLHEP::ns;
+
+        Npe = wStep.GetNpe();
     }
 };
 
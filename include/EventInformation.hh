@@ -0,0 +1,46 @@
+/// \file EventInformation.hh
+/// \brief Definition of the EventInformation class
+
+#ifndef EVENTINFORMATION_H
+#define EVENTINFORMATION_H 1
+
+#include "G4VUserEventInformation.hh"
+#include "globals.hh"
+
+
+/// Per-event information attached by GeneratorAction and written by EventAction.
+/// It records which source component generated the event and the weight of the event for normalization.
+//
+class EventInformation : public G4VUserEventInformation{
+
+public:
+
+    EventInformation( G4int code = 0, G4double weight = 1, G4int parent = -1 ) : sourceCode( code ), sourceWeight( weight ), parentEventID( parent ) {}
+
+    virtual ~EventInformation(){}
+
+    virtual void Print() const {
+        G4cout << "Source code " << sourceCode << ", weight " << sourceWeight << ", parent event " << parentEventID << G4endl;
+    }
+
+    void SetSourceCode( G4int a ){ sourceCode = a; }
+    G4int GetSourceCode() const { return sourceCode; }
+        // PDG code of the isotope generating the event, 0 if not applicable.
+
+    void SetSourceWeight( G4double a ){ sourceWeight = a; }
+    G4double GetSourceWeight() const { return sourceWeight; }
+
+    void SetParentEventID( G4int a ){ parentEventID = a; }
+    G4int GetParentEventID() const { return parentEventID; }
+        // for a decay stage split into its own event, the event in which the chain started. -1 otherwise.
+
+private:
+
+    G4int sourceCode;
+
+    G4double sourceWeight;
+
+    G4int parentEventID;
+};
+
+#endif
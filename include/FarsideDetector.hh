@@ -13,18 +13,23 @@
 
 #include "GeometryManager.hh"
 
+class G4LogicalVolume;
+
 class FarsideDetector{
 
 public:
     
     FarsideDetector( GeometryManager* gm );
 
-    ~FarsideDetector(){}
+    ~FarsideDetector();
 
     void PlaceDetector( G4String name, G4ThreeVector p = G4ThreeVector(0,0,0), G4RotationMatrix* r = 0 );
+        // Each call places another copy of the same logical volume, with copy numbers counted from 0.
 
 private:
 
+    G4LogicalVolume* BuildLogicalVolume();
+
     GeometryManager* fGeometryManager;
 
     G4double radius;
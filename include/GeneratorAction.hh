@@ -20,10 +20,14 @@
 #include "GeometryManager.hh"
 
 #include "RunAction.hh"
+#include "PhaseSpaceRecord.hh"
+#include "SpectrumSampler.hh"
+#include "DecayChainSampler.hh"
+#include "AliasTable.hh"
+#include "SurfaceSource.hh"
 
 #include "TFile.h"
 #include "TTree.h"
-#include "TH2F.h"
 
 class G4GeneralParticleSource;
 class G4ParticleGun;
@@ -43,23 +47,114 @@ public:
     virtual void GeneratePrimaries( G4Event* event );
 
     void SetSpectrum( G4String str );
-        // used to specify the gamma spectrum 
-		// from which to sample energy & momentum
+        // used to specify the spectrum file
+		// from which to sample particle, energy & momentum
+        // see SpectrumSampler for the supported histograms.
 
     void SetParticleName( G4String name );
         // used to specigy the particle being simulated
     	// when spectrum is used, particle name information is not available.
 		// Note: this function may be redundent with /gun/particle command.
-
-    G4double SetEnergy( double E );
-        // sets the energy by taking care of the unit
-        // ROOT spectrum file has unit keV
     
     void GPSSetMaterial( G4String materialName );
         // this function samples particle position based on material instead of volume.
 
+    void SetPhaseSpace( G4String fileName );
+        // replay particles recorded with /phaseSpace/recordAt
+        // particles belonging to the same recorded event are generated in the same event.
+
+    void SetPhaseSpaceRecycle( G4int n ){ phaseSpaceRecycle = n>0 ? n : 1; }
+        // each recorded event is replayed n times before moving to the next one.
+
+    void SetPhaseSpaceRotation( G4bool a ){ phaseSpaceRotation = a; }
+        // if true, a random rotation about z-axis is applied to each replayed event.
+
+    void SetPhaseSpaceTranslation( G4ThreeVector a ){ phaseSpaceTranslation = a; }
+        // translation applied to replayed positions after the rotation.
+
+    void SetDecayChain( G4String isotope );
+        // samples one member of the chain in secular equilibrium per event instead of the GPS particle.
+        // position is still sampled by GPS, e.g. confined in a material by /generator/setMaterial.
+
+    void SetDecayChainEmittersOnly( G4bool a );
+        // restrict the sampled members to gamma and beta emitters.
+
+    void AddIsotope( G4String isotope, G4double activity, G4String target );
+        // adds a component to the isotope mix: activity in Bq/kg, target is a material or a physical volume name.
+        // in each event, one component is chosen in proportion to activity x mass of the target
+        // and the ion is generated at rest inside the target. The PDG code of the ion is written as source.
+
+    void ClearIsotopes();
+
+    void SetSurface( G4String volumeName );
+        // particles enter the volume (G4Box or G4Tubs) through its surface with cosine-law angular distribution.
+        // particle and energy are taken from GPS.
+
+    void SetSurfaceFaces( G4String faces );
+        // space-separated list of faces, e.g. "+z side", or "all".
+
 private:
 
+    /// Source of primary particles.
+    //
+    enum GeneratorMode{
+        kGPS,           // GPS configured by macro, optionally confined to a material
+        kSpectrum,      // particle gun with energy and angle from a ROOT histogram
+        kPhaseSpace,    // replay of a recorded phase-space file
+        kIsotopeMix,    // ions at rest chosen from a list of (isotope, activity, target)
+        kSurface        // GPS particle and energy entering a volume through its surface
+    };
+
+    /// Physical volumes sharing a material (or a single named volume) with their cumulative mass.
+    //
+    struct VolumeGroup{
+        std::vector<G4VPhysicalVolume*> volumes;
+        std::vector<G4double> cumulativeMass;
+            // in kg, used to pick a volume by binary search.
+        G4double GetMass() const { return cumulativeMass.empty() ? 0 : cumulativeMass.back(); }
+    };
+
+    VolumeGroup FindVolumes( G4String target, G4bool materialOnly );
+        // volumes made of material named target, or (if materialOnly is false and no material matches) the volume named target.
+
+    G4VPhysicalVolume* PickVolume( const VolumeGroup& group );
+        // probability proportional to the mass of the volume.
+
+    G4double GetCopyMass( G4VPhysicalVolume* pv );
+        // mass in kg of all copies of pv (replicas, parameterised copies and placements of its mothers)
+
+    void ConfineToVolume( G4VPhysicalVolume* pv );
+        // GPS samples uniformly in the bounding box of a copy of pv and rejects points outside of it.
+
+    struct IsotopeComponent{
+        G4String name;
+        G4ParticleDefinition* ion;
+        G4double activity;
+            // Bq/kg
+        G4String target;
+        VolumeGroup group;
+    };
+
+    std::vector<IsotopeComponent> isotopes;
+
+    AliasTable isotopeTable;
+        // weights are the total activity (Bq) of each component.
+
+    void UpdateIsotopeMix();
+
+    SurfaceSource surface;
+
+    G4String surfaceVolume;
+    std::vector<G4String> surfaceFaces;
+
+    void UpdateSurface();
+
+    GeneratorMode fMode;
+
+    void GeneratePhaseSpacePrimaries( G4Event* event );
+
+    void GenerateStagePrimaries( G4Event* event, const DeferredStage& stage );
+
     GeneratorMessenger* primaryGeneratorMessenger;
 
     RunAction* fRunAction;
@@ -74,34 +169,62 @@ private:
     G4GeneralParticleSource*  fgps;
 		// more convenient in general cases
 
-    bool useGPS;
-        // true => use GPS to generate events
-        // false => use particle gun
-    
     bool GPSInMaterial;
         // if true, particles will be generated based on material
 
-    double fCumulativeMaterialVolume;
-        // total mass (actually) corresponding to a certain material
-    
-    std::vector<G4VPhysicalVolume*> fVolumesInMaterial;
-        // this vector contains list of volumes that uses a certain material
+    VolumeGroup fVolumesInMaterial;
+        // volumes that use the material set by /generator/setMaterial
         // this is updated each time the function is invoked.
 
+    G4String materialName;
+        // material set by /generator/setMaterial
+
+    G4int geometryVersion;
+        // version of the geometry the volume groups and the surface were found in
+
+    void UpdateVolumes();
+        // Finds the volumes of the material, the isotope targets and the surface again after the geometry is rebuilt,
+        // e.g. by /geometry/set between runs, since the old physical volumes have been deleted.
+
     G4String particle;
         // name of particle being simulated.
 
-    TFile* file;
-        // Pointer to the ROOT file containing 2D histogram.
+    SpectrumSampler spectrum;
+        // alias tables built from the spectrum file.
+
+    TFile* phaseSpaceFile;
+    TTree* phaseSpaceTree;
+        // phase-space records are streamed entry by entry from the file.
+
+    PhaseSpaceRecord phaseSpaceRecord;
+
+    Long64_t phaseSpaceEntry;
+        // first entry of the recorded event to be replayed next
+
+    G4int phaseSpaceRecycle;
+    G4int phaseSpaceRecycled;
+        // number of times the current recorded event has been replayed
+
+    DecayChainSampler decayChain;
+
+    bool useDecayChain;
+        // if true, GPS particle is replaced by a sampled chain member in each event.
+
+    void ResetMode();
+        // Drops the decay chain and restores the GPS energy when another source is selected.
+
+    void OverrideEnergy();
+        // Sets the GPS energy to 0 for ions decaying at rest, keeping the energy set by macro.
 
-    TH2F* hist2D;
-        // Pointer to the 2d histogram containing energy vs angle
+    void RestoreEnergy();
+        // Restores the GPS energy set by macro, if it was overridden.
 
-    G4double Energy;
-        // Energy
+    bool energyOverridden;
+    G4String savedEnergyType;
+    G4double savedMonoEnergy;
 
-    G4double Theta;
-        // polar angle w.r.t. a surface
+    G4bool phaseSpaceRotation;
+    G4ThreeVector phaseSpaceTranslation;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -18,6 +18,9 @@
 #include "G4UIcmdWithoutParameter.hh"
 #include "G4UIcmdWithADouble.hh"
 #include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
 
 class GeneratorAction;
 class G4UIdirectory;
@@ -53,6 +56,26 @@ private:
 	
     G4UIcmdWithAString* cmdGPSInMaterial;
 
+    G4UIcmdWithAString* cmdDecayChain;
+
+    G4UIcmdWithABool* cmdDecayChainEmittersOnly;
+
+    G4UIcmdWithAString* cmdAddIsotope;
+
+    G4UIcmdWithoutParameter* cmdClearIsotopes;
+
+    G4UIcmdWithAString* cmdSurface;
+
+    G4UIcmdWithAString* cmdSurfaceFaces;
+
+    G4UIcmdWithAString* cmdPhaseSpace;
+
+    G4UIcmdWithAnInteger* cmdPhaseSpaceRecycle;
+
+    G4UIcmdWithABool* cmdPhaseSpaceRotation;
+
+    G4UIcmdWith3VectorAndUnit* cmdPhaseSpaceTranslation;
+
 };
 
 #endif
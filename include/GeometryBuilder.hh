@@ -0,0 +1,85 @@
+/// \file GeometryBuilder.hh
+/// \brief Definition of the GeometryBuilder class
+
+#ifndef GEOMETRYBUILDER_H
+#define GEOMETRYBUILDER_H 1
+
+#include "ConfigParser.hh"
+
+#include "globals.hh"
+#include "G4RotationMatrix.hh"
+
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+
+using std::string;
+
+class G4VSolid;
+class G4LogicalVolume;
+class G4VPhysicalVolume;
+
+
+/// Builds the geometry described under volumes in the geometry config.
+/// Each directory under volumes is a volume, and directories nested inside it are its daughters.
+/// The single top-level volume must be named World.
+//
+class GeometryBuilder{
+
+public:
+
+    GeometryBuilder( ConfigParser* config, bool checkOverlaps );
+
+    ~GeometryBuilder();
+
+    G4VPhysicalVolume* Build();
+        // Creates solids, logical volumes and placements, and returns the physical world.
+
+private:
+
+    string GetClassName(){ return "GeometryBuilder"; }
+
+    void FindVolumes( const string& dir );
+        // Registers the directory of each volume by name, recursively.
+
+    vector<string> GetSubDirectories( const string& dir );
+
+    string GetName( const string& dir );
+        // Last component of a directory, e.g. Room for /volumes/World/Room/
+
+    G4VSolid* GetSolid( const string& name );
+        // Solids are looked up under solids first, then under volumes.
+
+    G4VSolid* BuildSolid( const string& name, const string& dir );
+
+    G4LogicalVolume* BuildLogicalVolume( const string& dir );
+
+    void PlaceDaughters( const string& dir );
+        // Places the daughters of the volume in dir, then their daughters.
+
+    G4double GetLengthUnit( const string& dir );
+        // From the unit parameter of the directory (mm, cm or m). cm by default.
+
+    G4RotationMatrix* GetRotation( const vector<double>& angles, size_t index );
+        // Rotation about x, y and z in this order with angles in degree. 0 for no rotation.
+
+    void Fatal( const string& message );
+
+    ConfigParser* fConfig;
+
+    bool fCheckOverlaps;
+
+    std::map< string, string > volumeDirs;
+        // volume name -> directory
+
+    std::map< string, G4VSolid* > solids;
+
+    std::map< string, G4LogicalVolume* > logicalVolumes;
+
+    std::set< string > solidsInProgress;
+        // to detect boolean solids that refer to themselves
+};
+
+
+#endif
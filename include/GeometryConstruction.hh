@@ -17,11 +17,16 @@
 
 #include "NaIDetector.hh"
 
+#ifdef WITH_GDML
+#include "G4GDMLParser.hh"
+#endif
+
 #include <string>
 
 using std::string;
 
 class GeometryConstructionMessenger;
+class G4UserLimits;
 
 
 /// Detector construction class to define materials and geometry.
@@ -39,6 +44,9 @@ public:
     /// An integer is used to identify the type of geometry/work being simulated
     /// This function converts the user-given string to appropriate integer for calling the right function
     /// 0 - rock
+    /// 1 - crystal
+    /// 2 - volumes described under volumes in the config
+    /// 3 - world read from the GDML file gdml/file
     /// 100s - NaI measurement
     ///     101 - 1.5-inch NaI in Kamioka in 202304
     ///     102 -   3-inch NaI in Kamioka in 202504
@@ -47,6 +55,22 @@ public:
     virtual G4VPhysicalVolume* Construct();
         // This method calls DefineMaterials and DefineVolumes successively.
 
+    void CheckOverlaps();
+        // Checks all placements after construction when overlaps/mode is deferred.
+        // The result is cached under the geometry hash, so that the same geometry is checked only once.
+
+    void ConfigureNavigation();
+        // Sets the smartless and voxel optimisation of volumes listed under navigation in the config.
+        // Called at the end of Construct(), before the voxels are built when the geometry is closed.
+
+    void ConstructRegions();
+        // Creates the regions listed under regions in the config, with their production cuts and user limits.
+        // Called at the end of Construct().
+
+    virtual void ConstructSDandField();
+        // Attaches biasing operators to the volumes listed in the config.
+        // Forced collision is specified by volume names under biasing/forceCollision.
+
     G4VPhysicalVolume* ConstructRock();
     
     G4VPhysicalVolume* ConstructCrystal();
@@ -55,16 +79,37 @@ public:
 
     G4VPhysicalVolume* ConstructKamiokaGamma2025( int option );
 
+    G4VPhysicalVolume* ConstructFromGDML();
+        // Reads the world from gdml/file, e.g. a world exported by a previous job.
+
+    void ExportGDML( G4VPhysicalVolume* world );
+        // Writes the constructed world to gdml/export, if given, so that it is embedded in the output.
+
 private:
 
     string GetClassName(){ return "GeometryConstruction"; }
 
+    G4LogicalVolume* FindLogicalVolume( G4String name );
+        // Names can be either physical or logical volume names. Returns 0 if not found.
+
+    void SetUserLimits( G4LogicalVolume* lv, G4UserLimits* limits );
+        // Applies the limits to the daughters of a region root that have no limits of their own,
+        // down to the roots of other regions.
+
+    G4String GetEmPhysicsName( G4String input );
+        // Converts short names (opt0-opt4, livermore, penelope) to the names used by G4EmParameters::AddPhysics.
+        // Returns an empty string for unknown options.
+
     GeometryManager* fGeometryManager;
     GeometryConstructionMessenger* fDetectorMessenger;
 
     bool fCheckOverlaps;
 
     NaIDetector detector_assembly;
+
+#ifdef WITH_GDML
+    G4GDMLParser fGDMLParser;
+#endif
 };
 
 
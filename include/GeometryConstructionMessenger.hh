@@ -61,6 +61,9 @@ private:
     G4UIcmdWithAnInteger* fTypeCmd;
 	
     G4UIcmdWithAString*   fConfigCmd;
+    G4UIcmdWithAnInteger* fPrecomputeMassCmd;
+    G4UIcmdWithAString*   fSetCmd;
+    G4UIcmdWithAnInteger* fLineOfSightCmd;
 };
 
 #endif
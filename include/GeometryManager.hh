@@ -8,6 +8,9 @@
 #define GEOMETRYMANAGER_H 1
 
 #include <map>
+#include <unordered_map>
+#include <vector>
+#include <string>
 #include <utility>
 
 #include "G4VUserDetectorConstruction.hh"
@@ -15,6 +18,8 @@
 #include "CLHEP/Units/PhysicalConstants.h"
 #include "G4NistManager.hh"
 #include "G4Transform3D.hh"
+#include "G4AffineTransform.hh"
+#include "G4VisExtent.hh"
 
 #include "G4Color.hh"
 
@@ -44,11 +49,55 @@ public:
 
     static G4LogicalVolume* GetLogicalVolume( G4String name );
         // return pointer to logical volume by name
+        // the name of a physical volume is looked up first, then that of a logical volume.
 
     static G4VPhysicalVolume* GetPhysicalVolume( G4String name );
-        // return pointer to physical volume by name
+        // return pointer to physical volume by name, 0 if not found
+        // if several volumes have the same name, the first one placed is returned.
 
-    static G4ThreeVector GetGlobalPosition( G4VPhysicalVolume* physVol );
+    static std::vector<G4VPhysicalVolume*> GetPhysicalVolumes( G4String name );
+        // all physical volumes with the name
+
+    static G4ThreeVector GetGlobalPosition( G4VPhysicalVolume* physVol, size_t instance = 0 );
+
+    static G4AffineTransform GetGlobalTransform( G4VPhysicalVolume* physVol, size_t instance = 0 );
+        // local to global transformation including rotations of the volume and all its mothers.
+        // A volume whose logical mother is placed several times has one instance per placement of the mother.
+        // Replicas and parameterised volumes have one instance per copy number (times the instances of their mother).
+
+    static size_t GetNumberOfInstances( G4VPhysicalVolume* physVol );
+
+    static G4VisExtent GetGlobalExtent( G4VPhysicalVolume* physVol, size_t instance = 0 );
+        // axis-aligned bounding box of the solid in global coordinates
+
+    void InvalidateIndex();
+        // The index of names and transformations, the geometry hash and the mass cache are rebuilt on the next lookup.
+        // Called when the geometry is (re)constructed or modified.
+
+    G4int GetGeometryVersion(){ return geometryVersion; }
+        // Incremented by InvalidateIndex. Classes holding pointers to physical volumes refresh them when it changes.
+
+    std::string GetGeometryHash();
+        // Hash of the names, solids with their dimensions, materials and placements of all volumes.
+
+    void SetCacheDirectory( G4String dir ){ cacheDirectory = dir; }
+        // Masses are stored in dir/<geometry hash>.mass and shared by jobs with the same geometry.
+
+    G4String GetCacheDirectory(){ return cacheDirectory; }
+
+    G4double GetMass( G4LogicalVolume* lv );
+        // Same as G4LogicalVolume::GetMass( false, false ), i.e. without daughters, but cached in memory and on disk.
+
+    void PrecomputeMass( G4int nStat );
+        // Computes the masses of all logical volumes, estimating the volume of boolean solids with nStat points,
+        // and stores them in the cache.
+
+    void SaveMassCache();
+
+    void SetGDMLFile( G4String file ){ gdmlFile = file; }
+        // GDML file of the constructed world, embedded in the output. Empty if the world was not exported.
+
+    G4String GetGDMLFile(){ return gdmlFile; }
     
     G4NistManager* GetMaterialManager();
 
@@ -65,6 +114,9 @@ public:
 
     void LoadFile( G4String );
         // reads configuration file and stores parameters as name-value pairs
+
+    void SetParameter( G4String name, G4String value );
+        // replaces a parameter of the configuration, e.g. /crystal/diameter, with the whitespace-separated values
 	
     void SetVisAttributes();
 
@@ -81,6 +133,54 @@ private:
 	
     int  fGeometryType; 
 
+private:
+
+    void BuildIndex();
+
+    void CheckIndex();
+        // Builds the index if invalid or if volumes were added since it was built.
+
+    void IndexVolume( G4VPhysicalVolume* pv, const G4AffineTransform& transform );
+
+    void IndexReplicas( G4VPhysicalVolume* pv, const G4AffineTransform& transform );
+        // One instance per copy of a replica or parameterised volume.
+
+    std::unordered_map< std::string, std::vector<G4VPhysicalVolume*> > volumeIndex;
+
+    std::unordered_map< const G4VPhysicalVolume*, std::vector<G4AffineTransform> > transformIndex;
+
+    bool indexBuilt;
+
+    size_t indexedVolumes;
+
+    G4int geometryVersion;
+        // size of the physical volume store when the index was built
+
+    std::string geometryHash;
+
+    struct MassEntry{
+        size_t index;
+            // position in the logical volume store
+        G4String name;
+        G4double volume;
+        G4double mass;
+        G4int nStat;
+            // number of points of the volume estimate, 0 if computed by Geant4 defaults
+    };
+
+    std::unordered_map< const G4LogicalVolume*, MassEntry > massCache;
+
+    bool massCacheLoaded;
+    bool massCacheModified;
+
+    std::string cacheDirectory;
+
+    std::string gdmlFile;
+
+    void LoadMassCache();
+
+    G4double GetCubicVolume( G4VSolid* solid, G4int nStat );
+
 private:
 
     ConfigParser config;
@@ -0,0 +1,102 @@
+/// \file LightCollectionMap.hh
+/// \brief Definition of the LightCollectionMap class
+
+#ifndef LIGHTCOLLECTIONMAP_H
+#define LIGHTCOLLECTIONMAP_H 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+class G4Event;
+class G4Step;
+class G4VPhysicalVolume;
+
+
+/// Probability that a scintillation photon emitted at a position in the crystal reaches the photocathode,
+/// on a grid over the bounding box of the crystal in its local coordinates.
+/// The map is generated once by tracking optical photons (--opticalMap) and is then used to convert
+/// energy deposits into photoelectrons without optical physics. Parameters are read from optical in the geometry config.
+//
+class LightCollectionMap{
+
+public:
+
+    LightCollectionMap( G4String output = "" );
+        // The map is generated and written to output if given, otherwise the map in optical/map is applied.
+
+    ~LightCollectionMap(){}
+
+    static void AddOpticalProperties();
+        // Refractive index and absorption length of the crystal and the windows, and a diffuse reflector around the crystal.
+        // Used only by optical photon transport, so harmless with physics lists without optical physics.
+
+    void Configure();
+        // Finds the crystal, and in production loads the map once.
+
+    bool IsGenerating(){ return outputName!=""; }
+
+    void GeneratePrimaries( G4Event* event );
+        // Optical photons emitted isotropically from a point sampled uniformly in the crystal.
+
+    void Score( const G4Step* step );
+        // Optical photons entering the photocathode are counted and killed.
+
+    void Fill( const G4Event* event );
+
+    void Save();
+
+    G4int GetPhotoelectrons( const G4Step* step );
+        // Poisson-distributed number of photoelectrons for the energy deposit of a step in the crystal.
+
+    G4double GetEfficiency( const G4ThreeVector& local ) const;
+        // Light collection efficiency at a point in the local coordinates of the crystal.
+        // Bins without emitted photons use the average of the map.
+
+    std::vector<G4String> GetSummary();
+
+    G4String GetClassName(){ return "LightCollectionMap"; }
+
+private:
+
+    void Load( G4String fileName );
+
+    G4int GetBin( const G4ThreeVector& local ) const;
+        // -1 if outside the grid
+
+    G4String outputName;
+
+    G4String volumeName;
+    G4String photocathodeName;
+
+    G4VPhysicalVolume* volume;
+        // deposits in any placement of its logical volume are converted
+
+    G4int nx, ny, nz;
+
+    G4ThreeVector lower;
+    G4ThreeVector upper;
+        // bounding box of the crystal in its local coordinates
+
+    std::vector<G4double> emitted;
+    std::vector<G4double> detected;
+
+    G4double average;
+        // detected over emitted photons of the whole map
+
+    G4int photonsPerEvent;
+    G4double photonEnergy;
+
+    G4double lightYield;
+        // photons per keV
+    G4double quantumEfficiency;
+
+    G4ThreeVector origin;
+        // emission point of the current event in local coordinates
+    G4int nDetected;
+
+    G4String mapFile;
+};
+
+#endif
@@ -0,0 +1,115 @@
+/// \file LineOfSight.hh
+/// \brief Definition of the LineOfSight class
+
+#ifndef LINEOFSIGHT_H
+#define LINEOFSIGHT_H 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4AffineTransform.hh"
+
+#include <vector>
+#include <random>
+
+class G4Navigator;
+class G4Material;
+class G4VPhysicalVolume;
+
+
+/// Deterministic estimate of the uncollided gamma flux in a detector from a source material.
+///
+/// Rays go from points sampled uniformly in the source material to points sampled uniformly in the
+/// detector. Along each ray, the path length in each material is weighted by the attenuation
+/// coefficient from G4EmCalculator at each gamma line. For a uniform emission density S of a line,
+/// the flux averaged over the detector is
+///     S x V x mean( exp(-sum mu l) / (4 pi d^2) )
+/// where V is the volume of the source material, estimated from the acceptance of the sampling.
+/// Rays are traced in parallel, each thread with its own navigator. In multi-threaded builds of Geant4,
+/// each thread sets up its own copy of the thread-local volume data, as the worker threads of Geant4 do.
+///
+/// Read from the geometry config, with activities in Bq/kg of the source material:
+///     attenuation {
+///         source : Rock,
+///         detector : NaICrystal,
+///         rays : 1000000,
+///         threads : 8,
+///         isotopes {
+///             K40 { activity : 300, lines : 1460.8, intensities : 0.1066, }
+///         }
+///     }
+//
+class LineOfSight{
+
+public:
+
+    LineOfSight();
+
+    ~LineOfSight(){}
+
+    void Run( G4int nRays );
+        // nRays of 0 uses attenuation/rays. Builds the physics tables and closes the geometry first, without a run.
+
+    std::vector<G4String> GetSummary(){ return summary; }
+        // isotope, line (keV), intensity, flux (1/cm2/s) and its statistical error, then the total of each isotope.
+
+    G4String GetClassName(){ return "LineOfSight"; }
+
+private:
+
+    struct Region{
+        G4VPhysicalVolume* pv;
+        G4AffineTransform transform;
+            // local to global
+        G4ThreeVector min;
+        G4ThreeVector max;
+            // bounding box in local coordinates
+    };
+
+    struct Sampler{
+        std::vector<Region> regions;
+        std::vector<G4double> cdf;
+            // regions are picked by the volume of their bounding boxes, so that accepted points are uniform
+        G4double boxVolume = 0;
+    };
+
+    struct Tally{
+        std::vector<G4double> sum;
+        std::vector<G4double> sum2;
+        long accepted = 0;
+        long attempts = 0;
+            // of source points, for the source volume
+    };
+
+    void AddRegion( Sampler& sampler, G4VPhysicalVolume* pv );
+
+    bool Sample( const Sampler& sampler, G4Navigator* navigator, std::mt19937_64& rng, G4ThreeVector& point, long& attempts );
+        // Uniform point in the sampled volumes outside their daughters. False after too many rejections.
+
+    void Trace( G4Navigator* navigator, const G4ThreeVector& start, const G4ThreeVector& end, std::vector<G4double>& tau );
+        // Adds mu x path length of each line along the straight segment.
+
+    void Work( G4int nRays, unsigned long seed, Tally& tally );
+
+    void WorkInThread( G4int nRays, unsigned long seed, Tally& tally );
+        // Work in a std::thread, with the geometry workspace of the thread set up in multi-threaded builds.
+
+    Sampler source;
+    Sampler detector;
+
+    G4VPhysicalVolume* world;
+
+    std::vector<G4String> isotopes;
+    std::vector<size_t> isotopeOfLine;
+    std::vector<G4double> energies;
+    std::vector<G4double> intensities;
+    std::vector<G4double> emission;
+        // gamma/mm3/s of each line
+
+    std::vector< std::vector<G4double> > mu;
+        // attenuation coefficient (1/mm) by material index and line
+
+    std::vector<G4String> summary;
+};
+
+
+#endif
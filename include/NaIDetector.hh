@@ -35,6 +35,8 @@ public:
 
     G4double GetLength();
 
+    void SetCheckOverlaps( bool a ){ fCheckOverlaps = a; }
+
 private:
 
     string GetClassName(){ return "NaIDetector"; }
@@ -0,0 +1,70 @@
+/// \file NavigationProfiler.hh
+/// \brief Definition of the NavigationProfiler class
+
+#ifndef NAVIGATIONPROFILER_H
+#define NAVIGATIONPROFILER_H 1
+
+#include "G4Navigator.hh"
+#include "globals.hh"
+
+#include <unordered_map>
+#include <vector>
+
+class G4LogicalVolume;
+class G4SmartVoxelHeader;
+
+
+/// Navigator for tracking that counts and times the calls to locate points and to compute steps
+/// per logical volume. Point location is attributed to the mother of the volume found, and steps
+/// to the current volume, whose daughters are the candidates of the step. Times include the
+/// overhead of the clock and are meant for comparing volumes rather than as absolute values.
+///
+/// It replaces the navigator for tracking when enabled, which has to happen before the run manager
+/// is constructed since the stepping manager and the transportation keep the navigator they find.
+//
+class NavigationProfiler : public G4Navigator{
+
+public:
+
+    NavigationProfiler();
+
+    virtual ~NavigationProfiler(){}
+
+    static NavigationProfiler* Enable();
+        // Creates the profiler and installs it as the navigator for tracking.
+
+    static NavigationProfiler* Get(){ return profiler; }
+        // 0 unless enabled.
+
+    virtual G4VPhysicalVolume* LocateGlobalPointAndSetup( const G4ThreeVector& point, const G4ThreeVector* direction = 0,
+                                                          const G4bool pRelativeSearch = true, const G4bool ignoreDirection = true );
+
+    virtual G4double ComputeStep( const G4ThreeVector& pGlobalPoint, const G4ThreeVector& pDirection,
+                                  const G4double pCurrentProposedStepLength, G4double& pNewSafety );
+
+    std::vector<G4String> GetReport();
+        // One line per logical volume with daughters or navigation calls:
+        // name, daughters, voxels, locate calls, locate time (s), step calls, step time (s)
+        // sorted by total time.
+
+    static G4int CountVoxels( G4SmartVoxelHeader* header );
+        // Number of distinct voxel nodes, including those of nested headers.
+
+    G4String GetClassName(){ return "NavigationProfiler"; }
+
+private:
+
+    static NavigationProfiler* profiler;
+
+    struct NavigationCost{
+        long locateCalls = 0;
+        double locateTime = 0;
+        long stepCalls = 0;
+        double stepTime = 0;
+    };
+
+    std::unordered_map< const G4LogicalVolume*, NavigationCost > costs;
+};
+
+
+#endif
@@ -0,0 +1,29 @@
+/// \file OpticalMapEventAction.hh
+/// \brief Definition of the OpticalMapEventAction class
+
+#ifndef OPTICALMAPEVENTACTION_H
+#define OPTICALMAPEVENTACTION_H 1
+
+#include "G4UserEventAction.hh"
+
+#include "LightCollectionMap.hh"
+
+
+/// Event action of the light collection map mode. Photons detected in each event are added to the bin of the emission point.
+//
+class OpticalMapEventAction : public G4UserEventAction{
+
+public:
+
+    OpticalMapEventAction( LightCollectionMap* map ) : G4UserEventAction(), fMap( map ) {}
+
+    virtual ~OpticalMapEventAction(){}
+
+    virtual void EndOfEventAction( const G4Event* event ){ fMap->Fill( event ); }
+
+private:
+
+    LightCollectionMap* fMap;
+};
+
+#endif
@@ -0,0 +1,29 @@
+/// \file OpticalMapGenerator.hh
+/// \brief Definition of the OpticalMapGenerator class
+
+#ifndef OPTICALMAPGENERATOR_H
+#define OPTICALMAPGENERATOR_H 1
+
+#include "G4VUserPrimaryGeneratorAction.hh"
+
+#include "LightCollectionMap.hh"
+
+
+/// Primary generator of the light collection map mode. Each event is a burst of optical photons at one point in the crystal.
+//
+class OpticalMapGenerator : public G4VUserPrimaryGeneratorAction{
+
+public:
+
+    OpticalMapGenerator( LightCollectionMap* map ) : G4VUserPrimaryGeneratorAction(), fMap( map ) {}
+
+    virtual ~OpticalMapGenerator(){}
+
+    virtual void GeneratePrimaries( G4Event* event ){ fMap->GeneratePrimaries( event ); }
+
+private:
+
+    LightCollectionMap* fMap;
+};
+
+#endif
@@ -0,0 +1,29 @@
+/// \file OpticalMapSteppingAction.hh
+/// \brief Definition of the OpticalMapSteppingAction class
+
+#ifndef OPTICALMAPSTEPPINGACTION_H
+#define OPTICALMAPSTEPPINGACTION_H 1
+
+#include "G4UserSteppingAction.hh"
+
+#include "LightCollectionMap.hh"
+
+
+/// Stepping action of the light collection map mode. Steps are not recorded; photons reaching the photocathode are counted.
+//
+class OpticalMapSteppingAction : public G4UserSteppingAction{
+
+public:
+
+    OpticalMapSteppingAction( LightCollectionMap* map ) : G4UserSteppingAction(), fMap( map ) {}
+
+    virtual ~OpticalMapSteppingAction(){}
+
+    virtual void UserSteppingAction( const G4Step* step ){ fMap->Score( step ); }
+
+private:
+
+    LightCollectionMap* fMap;
+};
+
+#endif
@@ -0,0 +1,67 @@
+/// \file PhaseSpaceRecord.hh
+/// \brief Definition of the PhaseSpaceRecord class
+
+#ifndef PHASESPACERECORD_H
+#define PHASESPACERECORD_H 1
+
+#include "globals.hh"
+#include "G4Step.hh"
+#include "G4ThreeVector.hh"
+#include "G4ParticleDefinition.hh"
+
+#include "TTree.h"
+
+
+/// A single particle crossing a boundary.
+/// It is written by RunAction into the phaseSpace TTree and read back by GeneratorAction to replay the particles as primaries.
+/// Particles from the same event share the same eventID so that correlations are preserved in replay.
+/// Units are mm, ns and keV.
+//
+class PhaseSpaceRecord{
+
+public:
+
+    PhaseSpaceRecord();
+
+    void Branch( TTree* tree );
+        // create branches for writing
+
+    void SetBranchAddress( TTree* tree );
+        // bind the variables to an existing tree for reading
+
+    void Fill( const G4Step* step );
+        // fill the variables with the post-step point of the step
+
+    G4int GetEventID(){ return eventID; }
+
+    G4int GetPDGCode(){ return pdg; }
+
+    G4ParticleDefinition* GetParticleDefinition();
+        // returns 0 if particle cannot be found from the PDG code
+
+    G4ThreeVector GetPosition();
+
+    G4ThreeVector GetMomentumDir();
+
+    G4double GetEnergy();
+
+    G4double GetTime();
+
+    G4double GetWeight(){ return w; }
+
+private:
+
+    Int_t eventID;
+    Int_t pdg;
+
+    Float_t x, y, z;
+    Float_t px, py, pz;
+
+    Float_t E;
+    Double_t t;
+        // double since global time after radioactive decay can be very large
+
+    Float_t w;
+};
+
+#endif
@@ -0,0 +1,70 @@
+/// \file PhysicsTableCache.hh
+/// \brief Definition of the PhysicsTableCache class
+
+#ifndef PHYSICSTABLECACHE_H
+#define PHYSICSTABLECACHE_H 1
+
+#include "globals.hh"
+
+#include <string>
+
+
+/// Singleton class.
+/// On-disk cache of physics tables shared by jobs with the same physics, cuts and materials.
+///
+/// The key is built from the Geant4 version, the physics list, the production cuts of all regions,
+/// the EM parameters that change the tables (energy range, MSC, de-excitation, ...), the EM options per
+/// region and the composition of all materials once the geometry is constructed.
+/// Tables are kept in a sub-directory named after the hash of the key, together with a key file that
+/// holds the full key and the size of each table file. Tables are retrieved only when the key and all
+/// file sizes match; otherwise they are built as usual and stored after the first run is initialized.
+/// Only tables written by StorePhysicsTable, i.e. the EM tables, are cached; hadronic cross sections are always built.
+//
+class PhysicsTableCache{
+
+private:
+
+    PhysicsTableCache();
+
+    ~PhysicsTableCache(){}
+
+    static PhysicsTableCache* cache;
+
+public:
+
+    static PhysicsTableCache* Get();
+
+    void SetDirectory( G4String dir, G4String physics );
+        // Enables the cache. physics identifies the physics list and options given in main.
+
+    bool Enabled(){ return directory!=""; }
+
+    void Prepare();
+        // Called after the geometry is constructed and before the physics tables are built.
+        // Sets the physics list to retrieve tables if a valid cache exists.
+
+    void Store();
+        // Called when the physics tables exist, i.e. at the beginning of a run.
+        // Stores the tables if they were not retrieved.
+
+    G4String GetClassName(){ return "PhysicsTableCache"; }
+
+private:
+
+    std::string BuildKey();
+
+    bool Verify( const std::string& dir, const std::string& key );
+        // true if the key file in dir holds the same key and all files have the recorded sizes.
+
+    std::string directory;
+
+    std::string physicsName;
+
+    std::string currentKey;
+    std::string currentDir;
+
+    bool pending;
+        // true if the tables of the current key need to be stored.
+};
+
+#endif
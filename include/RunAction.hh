@@ -20,10 +20,20 @@
 #include <vector>
 #include <sstream>
 #include <set>
+#include <map>
 
 #include "utility.hh"
+#include "PhaseSpaceRecord.hh"
+#include "AdjointScorer.hh"
+#include "DeferredStage.hh"
+#include "EarlyAbort.hh"
+#include "TargetBoxes.hh"
+#include "LightCollectionMap.hh"
+
+#include <deque>
 
 class G4Run;
+class G4Step;
 class RunActionMessenger;
 
 class RunAction : public G4UserRunAction {
@@ -66,9 +76,54 @@ public:
     void AddExcludeProcess( G4String a);
     bool ExcludeProcess( G4String a);
 
+    void SetEarlyAbort( bool a );
+    EarlyAbort* GetEarlyAbort(){ return earlyAbort; }
+        // Non-zero when events are aborted once no track can reach a recordWhenHit volume.
+
+    void AddRangeKillVolume( G4String a);
+    bool RangeKillVolume( G4String a);
+        // In these volumes, charged particles that cannot reach a recordWhenHit volume deposit their energy locally.
+
+    TargetBoxes* GetRecordBoxes(){ return &recordBoxes; }
+        // Bounding boxes of the recordWhenHit volumes.
+
     void AddKillWhenHit( G4String a);
     bool KillWhenHit( G4String a);
 
+    void AddPhaseSpaceVolume( G4String a);
+    bool PhaseSpaceVolume( G4String a);
+        // Particles entering these volumes are written to the phaseSpace tree.
+
+    TTree* GetPhaseSpaceTree();
+
+    void FillPhaseSpace( const G4Step* step );
+
+    void SetMetadata( G4String name, std::vector<G4String> lines );
+        // Lines are written to the output as a TMacro with the given name.
+        // Used to record source configuration needed for normalization.
+
+    void AddCount( G4String name, long n = 1 ){ counters[name] += n; }
+        // Counters (e.g. killed tracks, aborted events) are written to the counters macro for normalization.
+
+    void PushStage( const DeferredStage& a ){ stageQueue.push_back( a ); }
+    bool PopStage( DeferredStage& a );
+        // Decay stages split from their events by StackingAction, generated as events by GeneratorAction.
+
+    void SetKillDaughterNuclei( bool a ){ killDaughterNuclei = a; }
+    bool KillDaughterNuclei(){ return killDaughterNuclei; }
+        // If true, ground-state nuclei produced by radioactive decay are not tracked.
+        // Used when chain members are sampled directly by the generator.
+
+    void SetRunTag( G4String a ){ runTag = a; }
+        // Each run is listed in the runs macro as: run ID, number of events and tag.
+
+    void SetAdjointScorer( AdjointScorer* a ){ adjointScorer = a; }
+        // In adjoint mode, scores of each adjoint event are written to the adjoint tree.
+
+    void SetLightCollectionMap( LightCollectionMap* a ){ lightMap = a; }
+    LightCollectionMap* GetLightCollectionMap(){ return lightMap; }
+        // Generated in the light collection map mode, or loaded when optical/map is in the geometry config.
+
     G4String GetClassName(){ return "RunAction"; }
 
 private:
@@ -84,6 +139,12 @@ private:
     TFile* outputFile;
     TTree* dataTree;
 
+    TTree* phaseSpaceTree;
+    PhaseSpaceRecord phaseSpaceRecord;
+
+    TTree* adjointTree;
+    AdjointScorer* adjointScorer;
+
     std::vector< G4String > macros;
     std::vector< long > randomSeeds;
 
@@ -95,6 +156,32 @@ private:
     std::set< G4String > excludeVolume;
     std::set< G4String > excludeProcess;
 
+    std::set< G4String > phaseSpaceVolume;
+
+    std::set< G4String > rangeKillVolume;
+
+    TargetBoxes recordBoxes;
+
+    std::map< G4String, std::vector<G4String> > metadata;
+
+    std::vector<G4String> GetGeometryTable();
+        // name, mass (kg) of all copies and material of each physical volume
+
+    G4int geometryVersion;
+        // geometry of the last geometryTable
+
+    std::map< G4String, long > counters;
+
+    std::deque< DeferredStage > stageQueue;
+
+    EarlyAbort* earlyAbort;
+
+    LightCollectionMap* lightMap;
+
+    bool killDaughterNuclei;
+
+    G4String runTag;
+
 };
 
 
@@ -18,6 +18,7 @@ class RunAction;
 class G4UIcommand;
 class G4UIdirectory;
 class G4UIcmdWithAString;
+class G4UIcmdWithABool;
 
 class RunActionMessenger: public G4UImessenger{
 
@@ -43,6 +44,15 @@ private:
     G4UIcmdWithAString* fCmdExcludeVolume;
     G4UIcmdWithAString* fCmdExcludeProcess;
 
+    G4UIcmdWithABool* fCmdEarlyAbort;
+    G4UIcmdWithAString* fCmdRangeKill;
+
+    G4UIcmdWithAString* fCmdRunTag;
+
+    G4UIdirectory* fPhaseSpaceDir;
+
+    G4UIcmdWithAString* fCmdPhaseSpace;
+
 };
 
 #endif
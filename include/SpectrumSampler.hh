@@ -0,0 +1,76 @@
+/// \file SpectrumSampler.hh
+/// \brief Definition of the SpectrumSampler class
+
+#ifndef SPECTRUMSAMPLER_H
+#define SPECTRUMSAMPLER_H 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include "AliasTable.hh"
+
+#include <vector>
+
+class TH1;
+class THnBase;
+
+
+/// Samples particle species, energy and direction from histograms in a ROOT file.
+///
+/// Every TH1, TH2, TH3 and THn/THnSparse in the file is a component.
+/// The axes are energy (keV), polar angle theta (rad) and azimuthal angle phi (rad), in this order.
+/// If the name of the histogram is a particle name, the component is of that particle.
+/// Otherwise the default particle (/generator/particle) is used.
+/// Components are sampled in proportion to their integrals.
+///
+/// The histograms are converted into alias tables over the non-empty bins when loaded, and the file is closed.
+/// Values are sampled uniformly within the selected bin.
+//
+class SpectrumSampler{
+
+public:
+
+    SpectrumSampler();
+
+    ~SpectrumSampler(){}
+
+    bool Load( G4String fileName );
+        // returns false if the file cannot be opened or contains no usable histogram.
+
+    bool empty(){ return componentTable.empty(); }
+
+    void Sample( G4String& particle, G4double& energy, G4ThreeVector& direction );
+        // particle is left unchanged if the component has no particle name.
+
+private:
+
+    /// One histogram in the spectrum file.
+    //
+    struct Component{
+
+        G4String particle;
+            // empty if the default particle is to be used
+
+        G4int dimension;
+
+        std::vector<G4double> binLow;
+        std::vector<G4double> binWidth;
+            // flattened as 3 values per non-empty bin, unused dimensions are 0.
+
+        AliasTable table;
+    };
+
+    std::vector<Component> components;
+
+    AliasTable componentTable;
+
+    void AddHistogram( TH1* hist );
+
+    void AddTHn( THnBase* hist );
+
+    void AddComponent( Component& component, const std::vector<G4double>& weights );
+
+    G4String GetParticleName( G4String histName );
+};
+
+#endif
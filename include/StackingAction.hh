@@ -15,7 +15,20 @@
 #include "utility.hh"
 #include "globals.hh"
 
+#include "DeferredStage.hh"
+
+#include <map>
+#include <set>
+#include <vector>
+
+class G4ParticleDefinition;
+class StackingActionMessenger;
+
 /// Stacking action class : manage the newly generated particles
+///
+/// Radioactive decay products created later than the time window are deferred to the waiting stack.
+/// At each new stage, only the products of the earliest deferred decay (within one time window) are released,
+/// with time measured from that decay. Stages are thus processed in the order of the original decay time.
 
 class StackingAction : public G4UserStackingAction{
 
@@ -29,6 +42,21 @@ public:
 
     virtual void NewStage();
         //!< This function is called to insert a special event marker for resetting time.
+        //!< Deferred tracks are reclassified so that only the earliest decay is released.
+
+    virtual void PrepareNewEvent();
+
+    void SetTimeWindow( G4double a ){ timeWindow = a; }
+        //!< Decay products later than this are deferred to a new stage. Default 1 ms.
+
+    void SetMaxWaiting( G4int a ){ maxWaiting = a; }
+        //!< Maximum number of deferred tracks. Further deferred tracks are killed and counted. 0 for no limit.
+
+    void SetSplitStages( G4bool a ){ splitStages = a; }
+        //!< If true, deferred decays are removed from the event and queued as separate events (see GeneratorAction).
+
+    void AddStopChainAfter( G4ParticleDefinition* ion ){ stopChainAfter.insert( ion ); }
+        //!< Ground state of these nuclei produced by radioactive decay are not tracked.
 
 private:
 
@@ -37,8 +65,33 @@ private:
     EventAction* fEventAction;
         //!< Pointer to EventAction class.
         //!< When a radioactive decay happens with long timescale, this pointer is used to insert a special marker in the step collections to reset time.
+
+    StackingActionMessenger* fMessenger;
+
+    void SplitStages();
+
+    G4ClassificationOfNewTrack Classify( const G4Track* track );
+        //!< classification of the track; ClassifyNewTrack adds bookkeeping for early abort.
+
+    G4double timeWindow;
+
+    G4int maxWaiting;
+
+    std::set< G4ParticleDefinition* > stopChainAfter;
+
+    std::map< const G4Track*, G4double > deferred;
+        //!< Deferred tracks and the global time at which they were produced.
+
+    G4bool reclassifying;
+
+    G4bool splitStages;
+
+    std::vector< std::pair<G4double, DeferredStage::Track> > harvested;
+        //!< deferred tracks taken out of the event in split mode, with their original time
+
+    G4double stageStart;
+        //!< original time of the decay released in the current stage
 };
 
 
 #endif
-
@@ -0,0 +1,42 @@
+/// \file StackingActionMessenger.hh
+/// \brief Definition of the StackingActionMessenger class
+
+#ifndef STACKINGACTIONMESSENGER_H
+#define STACKINGACTIONMESSENGER_H 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class StackingAction;
+
+class G4UIcommand;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithABool;
+
+class StackingActionMessenger: public G4UImessenger{
+
+public:
+
+    StackingActionMessenger( StackingAction* );
+
+    ~StackingActionMessenger();
+
+    virtual void SetNewValue( G4UIcommand*, G4String );
+
+private:
+
+    StackingAction* fStackingAction;
+
+    G4UIdirectory* fDir;
+
+    G4UIcmdWithADoubleAndUnit* fCmdTimeWindow;
+    G4UIcmdWithAnInteger* fCmdMaxWaiting;
+    G4UIcmdWithAString* fCmdStopChainAfter;
+    G4UIcmdWithABool* fCmdSplitStages;
+
+};
+
+#endif
@@ -57,6 +57,12 @@ public:
     void SetEdep(G4double a){ Edep = a;}
     G4double GetEdep(){ return Edep;}
 
+    void SetWi(G4double a){ Wi = a;}
+    G4double GetWi(){ return Wi;}
+
+    void SetWf(G4double a){ Wf = a;}
+    G4double GetWf(){ return Wf;}
+
     void SetPosition(G4ThreeVector a){ position = a;}
     G4ThreeVector GetPosition(){ return position;}
 
@@ -69,6 +75,9 @@ public:
     void SetProcessName(G4String s){ processName = s;}
     G4String GetProcessName(){ return processName;}
 
+    void SetNpe(G4int a){ Npe = a;}
+    G4int GetNpe(){ return Npe;}
+
 private:
 
     G4int eventID;
@@ -87,11 +96,19 @@ private:
     G4double Ekf;
     G4double Edep;
 
+    G4double Wi;
+    G4double Wf;
+        // statistical weight of the track before and after the step
+        // With forced collision, Wf/Wi of the biased step is the interaction (or non-interaction) probability.
+
     G4ThreeVector position;
     G4ThreeVector momentumDir;
     G4double globalTime;
 
     G4String processName;
+
+    G4int Npe;
+        // photoelectrons from the light collection map, 0 outside the crystal
 };
 
 #endif
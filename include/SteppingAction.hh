@@ -38,6 +38,9 @@ public:
 
 private:
 
+    void RangeKill( const G4Step* step );
+        // Deposits the kinetic energy locally if the particle cannot leave a rangeKill volume towards a recorded volume.
+
     RunAction* fRunAction;
 
     EventAction* fEventAction;
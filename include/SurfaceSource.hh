@@ -0,0 +1,84 @@
+/// \file SurfaceSource.hh
+/// \brief Definition of the SurfaceSource class
+
+#ifndef SURFACESOURCE_H
+#define SURFACESOURCE_H 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4PhysicalConstants.hh"
+
+#include "AliasTable.hh"
+
+#include <vector>
+
+class G4VPhysicalVolume;
+
+
+/// Samples position and direction of particles entering a box or a cylinder through its surface.
+///
+/// Faces of a G4Box are +x, -x, +y, -y, +z, -z; faces of a G4Tubs are side, +z, -z, and phiStart, phiEnd
+/// for a segment. The side and the ends of a G4Tubs cover only its phi range and the ends exclude the bore.
+/// A face is chosen in proportion to its area, the position is uniform on the face
+/// and the direction follows the cosine law about the inward normal.
+/// This is the angular distribution of particles crossing a surface in an isotropic field,
+/// so N generated particles correspond to a time N / (J x area), where J is the inward current per unit area.
+//
+class SurfaceSource{
+
+public:
+
+    SurfaceSource(){}
+
+    ~SurfaceSource(){}
+
+    bool Set( G4VPhysicalVolume* pv, const std::vector<G4String>& faces );
+        // an empty list or "all" selects all faces.
+        // faces are converted to global coordinates with GeometryManager::GetGlobalTransform (first placement).
+
+    bool empty(){ return table.empty(); }
+
+    void Sample( G4ThreeVector& position, G4ThreeVector& direction );
+
+    G4double GetArea(){ return table.GetTotal(); }
+        // total area of the selected faces in m2
+
+    std::vector<G4String> GetSummary();
+        // one line per face: name and area in m2
+
+private:
+
+    enum FaceShape{
+        kRectangle,     // centre +/- halfU*u +/- halfV*v
+        kAnnulus,       // centre + r(cos, sin) in the u-v plane, r in [rMin, rMax], phi in the phi range
+        kCylinder       // radius rMax about the v-axis, half length halfV, phi in the phi range
+    };
+
+    struct Face{
+        G4String name;
+        FaceShape shape;
+        G4ThreeVector centre;
+        G4ThreeVector u;
+        G4ThreeVector v;
+        G4ThreeVector normal;
+            // inward normal, not used for cylinder side
+        G4double halfU;
+        G4double halfV;
+        G4double rMin;
+        G4double rMax;
+        G4double phiStart = 0;
+        G4double phiDelta = CLHEP::twopi;
+            // phi range of annulus and cylinder, measured from u
+        G4double area;
+    };
+
+    G4String volumeName;
+
+    std::vector<Face> faces;
+
+    AliasTable table;
+
+    static G4ThreeVector SampleCosineLaw( const G4ThreeVector& normal );
+};
+
+#endif
@@ -0,0 +1,44 @@
+/// \file TargetBoxes.hh
+/// \brief Definition of the TargetBoxes class
+
+#ifndef TARGETBOXES_H
+#define TARGETBOXES_H 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <set>
+#include <vector>
+
+
+/// Global bounding boxes of a set of volumes, used to bound the distance from a point to the nearest of them.
+/// Boxes are the global extents from GeometryManager, one per placement, built when first used.
+//
+class TargetBoxes{
+
+public:
+
+    TargetBoxes(){ built = false; }
+
+    ~TargetBoxes(){}
+
+    void SetVolumes( const std::set<G4String>& volumes );
+
+    bool empty();
+
+    G4double Distance( const G4ThreeVector& position );
+        // 0 inside a box, DBL_MAX if there is no box.
+
+private:
+
+    std::set<G4String> names;
+
+    std::vector<G4ThreeVector> boxMin;
+    std::vector<G4ThreeVector> boxMax;
+
+    bool built;
+
+    void Build();
+};
+
+#endif
@@ -31,6 +31,9 @@ public:
     virtual void PreUserTrackingAction(const G4Track*);
         //!< This method inserts a special step at the beginning of the track.
 
+    virtual void PostUserTrackingAction(const G4Track*);
+        //!< Aborts the event if no remaining track can reach a recordWhenHit volume.
+
 private:
 
     RunAction* fRunAction;
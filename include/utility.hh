@@ -28,6 +28,11 @@ string IsKey( string s);
 string FormatArgument( bool& isKey, string s );
 
 
+/// 64-bit FNV-1a hash of the string as 16 hexadecimal digits.
+/// Used to name cache files; stable across platforms and builds.
+string HashString( const string& s );
+
+
 class CommandlineArguments{
 
 public:
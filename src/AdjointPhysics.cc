@@ -0,0 +1,110 @@
+/// \file AdjointPhysics.cc
+/// \brief Implementation of the AdjointPhysics class
+
+#include "AdjointPhysics.hh"
+
+#include "G4ProcessManager.hh"
+#include "G4ProcessTable.hh"
+#include "G4VEmProcess.hh"
+#include "G4VEnergyLossProcess.hh"
+#include "G4Gamma.hh"
+#include "G4Electron.hh"
+
+#include "G4AdjointGamma.hh"
+#include "G4AdjointElectron.hh"
+#include "G4AdjointCSManager.hh"
+#include "G4AdjointSimManager.hh"
+
+#include "G4AdjointComptonModel.hh"
+#include "G4AdjointPhotoElectricModel.hh"
+#include "G4AdjointeIonisationModel.hh"
+#include "G4AdjointBremsstrahlungModel.hh"
+
+#include "G4eInverseCompton.hh"
+#include "G4InversePEEffect.hh"
+#include "G4eInverseIonisation.hh"
+#include "G4eInverseBremsstrahlung.hh"
+#include "G4ContinuousGainOfEnergy.hh"
+#include "G4AdjointAlongStepWeightCorrection.hh"
+
+
+AdjointPhysics::AdjointPhysics( const G4String& name ) : G4VPhysicsConstructor( name ){}
+
+
+void AdjointPhysics::ConstructParticle(){
+    G4AdjointGamma::AdjointGamma();
+    G4AdjointElectron::AdjointElectron();
+}
+
+
+void AdjointPhysics::ConstructProcess(){
+
+    G4ParticleDefinition* adjGamma = G4AdjointGamma::AdjointGamma();
+    G4ParticleDefinition* adjElectron = G4AdjointElectron::AdjointElectron();
+
+    // Direct processes of the forward physics list.
+    //
+    G4ProcessTable* processTable = G4ProcessTable::GetProcessTable();
+    G4VEmProcess* compton = dynamic_cast<G4VEmProcess*>( processTable->FindProcess( "compt", G4Gamma::Gamma() ) );
+    G4VEmProcess* photoElectric = dynamic_cast<G4VEmProcess*>( processTable->FindProcess( "phot", G4Gamma::Gamma() ) );
+    G4VEnergyLossProcess* ionisation = dynamic_cast<G4VEnergyLossProcess*>( processTable->FindProcess( "eIoni", G4Electron::Electron() ) );
+    G4VEnergyLossProcess* bremsstrahlung = dynamic_cast<G4VEnergyLossProcess*>( processTable->FindProcess( "eBrem", G4Electron::Electron() ) );
+
+    if( compton==0 || photoElectric==0 || ionisation==0 || bremsstrahlung==0 ){
+        G4Exception( "AdjointPhysics::ConstructProcess", "Adjoint001", FatalException,
+                     "direct compt, phot, eIoni or eBrem process not found. Is the gamma general process disabled?" );
+        return;
+    }
+
+    G4AdjointCSManager* csManager = G4AdjointCSManager::GetAdjointCSManager();
+    csManager->RegisterAdjointParticle( adjElectron );
+    csManager->RegisterAdjointParticle( adjGamma );
+    csManager->RegisterEmProcess( compton, G4Gamma::Gamma() );
+    csManager->RegisterEmProcess( photoElectric, G4Gamma::Gamma() );
+    csManager->RegisterEnergyLossProcess( ionisation, G4Electron::Electron() );
+    csManager->RegisterEnergyLossProcess( bremsstrahlung, G4Electron::Electron() );
+
+    G4AdjointSimManager::GetInstance()->ConsiderParticleAsPrimary( "gamma" );
+    G4AdjointSimManager::GetInstance()->ConsiderParticleAsPrimary( "e-" );
+
+    // Adjoint models.
+    // Each reverse reaction has a projectile-to-projectile and a product-to-projectile case.
+    //
+    G4AdjointComptonModel* comptonModel = new G4AdjointComptonModel();
+    comptonModel->SetSecondPartOfSameType( false );
+    comptonModel->SetDirectProcess( compton );
+    comptonModel->SetUseMatrix( false );
+
+    G4AdjointPhotoElectricModel* photoElectricModel = new G4AdjointPhotoElectricModel();
+
+    G4AdjointeIonisationModel* ionisationModel = new G4AdjointeIonisationModel();
+    ionisationModel->SetUseMatrix( false );
+
+    G4AdjointBremsstrahlungModel* bremsstrahlungModel = new G4AdjointBremsstrahlungModel();
+    bremsstrahlungModel->SetUseMatrix( false );
+
+    // Adjoint electron: continuous gain of energy, weight correction and reverse discrete reactions.
+    //
+    G4ContinuousGainOfEnergy* gainOfEnergy = new G4ContinuousGainOfEnergy();
+    gainOfEnergy->SetLossFluctuations( true );
+    gainOfEnergy->SetDirectEnergyLossProcess( ionisation );
+    gainOfEnergy->SetDirectParticle( G4Electron::Electron() );
+
+    G4ProcessManager* pmanager = adjElectron->GetProcessManager();
+    pmanager->AddContinuousProcess( gainOfEnergy );
+    pmanager->AddContinuousProcess( new G4AdjointAlongStepWeightCorrection() );
+    pmanager->AddDiscreteProcess( new G4eInverseIonisation( true, "Inv_eIon", ionisationModel ) );
+    pmanager->AddDiscreteProcess( new G4eInverseIonisation( false, "Inv_eIon1", ionisationModel ) );
+    pmanager->AddDiscreteProcess( new G4eInverseBremsstrahlung( true, "Inv_eBrem", bremsstrahlungModel ) );
+    pmanager->AddDiscreteProcess( new G4eInverseCompton( false, "Inv_Compt1", comptonModel ) );
+
+    // Adjoint gamma.
+    //
+    pmanager = adjGamma->GetProcessManager();
+    pmanager->AddContinuousProcess( new G4AdjointAlongStepWeightCorrection() );
+    pmanager->AddDiscreteProcess( new G4eInverseCompton( true, "Inv_Compt", comptonModel ) );
+    pmanager->AddDiscreteProcess( new G4eInverseBremsstrahlung( false, "Inv_eBrem1", bremsstrahlungModel ) );
+    pmanager->AddDiscreteProcess( new G4InversePEEffect( "Inv_PEEffect", photoElectricModel ) );
+
+    G4cout << GetClassName() << ": reverse EM processes registered for adj_gamma and adj_e-" << G4endl;
+}
@@ -0,0 +1,173 @@
+/// \file AdjointScorer.cc
+/// \brief Implementation of the AdjointScorer class
+
+#include "AdjointScorer.hh"
+#include "GeometryManager.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4Material.hh"
+#include "G4AdjointGamma.hh"
+#include "G4AdjointSimManager.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <sstream>
+#include <cmath>
+
+
+AdjointScorer::AdjointScorer() : tree(0), window(0.01), Eadj(0), weight(0), nScore(0) {}
+
+
+void AdjointScorer::Configure(){
+
+    const ConfigParser* config = GeometryManager::Get()->GetConfigParser();
+
+    materials.clear();
+    lines.clear();
+
+    std::vector<std::string> mat = config->GetStrArray( "/adjoint/materials" );
+    for( size_t i=0; i<mat.size(); i++ ){
+        materials.push_back( mat[i] );
+    }
+
+    std::vector<std::string> energies = config->GetStrArray( "/adjoint/lines" );
+    for( size_t i=0; i<energies.size(); i++ ){
+        lines.push_back( std::stod( energies[i] ) );
+    }
+
+    window = config->Find( "/adjoint/window" ) ? config->GetDouble( "/adjoint/window", 0.01 ) : 0.01;
+
+    if( materials.empty() || lines.empty() ){
+        G4cerr << "AdjointScorer: adjoint/materials or adjoint/lines not set in the config. Nothing will be scored." << G4endl;
+    }
+
+    nScore = materials.size()*lines.size();
+    score.assign( nScore>0 ? nScore : 1, 0. );
+    rate.assign( nScore>0 ? nScore : 1, 0. );
+
+    // Emission density of each (material, line) from the activities of the parents of the lines.
+    //
+    emission.assign( nScore>0 ? nScore : 1, 0. );
+
+    std::vector<double> intensities = const_cast<ConfigParser*>( config )->GetDoubleArray( "/adjoint/intensities" );
+    if( nScore>0 && intensities.size()!=lines.size() ){
+        G4cerr << "AdjointScorer: adjoint/intensities should have one value per line. Rates will be 0." << G4endl;
+        return;
+    }
+
+    for( size_t m=0; m<materials.size(); m++ ){
+
+        G4String dir = "/adjoint/activity/" + materials[m];
+        if( !config->Find( dir ) ){
+            G4cerr << "AdjointScorer: no " << dir.substr(1) << ". Rates of " << materials[m] << " will be 0." << G4endl;
+            continue;
+        }
+
+        std::vector<double> activities = const_cast<ConfigParser*>( config )->GetDoubleArray( dir );
+        G4Material* material = G4Material::GetMaterial( materials[m], false );
+        if( activities.size()!=lines.size() || material==0 ){
+            G4cerr << "AdjointScorer: " << dir.substr(1) << " should have one activity per line of an existing material. Rates of "
+                << materials[m] << " will be 0." << G4endl;
+            continue;
+        }
+
+        for( size_t l=0; l<lines.size(); l++ ){
+            emission[ m*lines.size()+l ] = activities[l] * intensities[l] * material->GetDensity()/(kg/cm3);
+        }
+    }
+}
+
+
+void AdjointScorer::Branch( TTree* t ){
+
+    tree = t;
+
+    tree->Branch( "Eadj", &Eadj, "Eadj/D" );
+    tree->Branch( "weight", &weight, "weight/D" );
+    tree->Branch( "nScore", &nScore, "nScore/I" );
+    tree->Branch( "score", score.data(), "score[nScore]/D" );
+    tree->Branch( "rate", rate.data(), "rate[nScore]/D" );
+}
+
+
+std::vector<G4String> AdjointScorer::GetSummary(){
+
+    std::vector<G4String> summary;
+    std::stringstream ss;
+
+    ss << "# index material line(keV) emission(gamma/cm3/s); window = " << window << "; score in cm/keV; rate = emission x score";
+    summary.push_back( ss.str() );
+
+    for( size_t m=0; m<materials.size(); m++ ){
+        for( size_t l=0; l<lines.size(); l++ ){
+            ss.str("");
+            ss << m*lines.size()+l << ' ' << materials[m] << ' ' << lines[l] << ' ' << emission[ m*lines.size()+l ];
+            summary.push_back( ss.str() );
+        }
+    }
+
+    ss.str("");
+    ss << "adjointSourceArea " << G4AdjointSimManager::GetInstance()->GetAdjointSourceArea()/cm2 << " cm2";
+    summary.push_back( ss.str() );
+
+    return summary;
+}
+
+
+void AdjointScorer::Score( const G4Step* step ){
+
+    if( nScore==0 ){
+        return;
+    }
+
+    const G4Track* track = step->GetTrack();
+    if( track->GetDefinition()!=G4AdjointGamma::AdjointGamma() ){
+        return;
+    }
+
+    // Energy of adjoint gamma does not change along the step.
+    //
+    G4String material = step->GetPreStepPoint()->GetMaterial()->GetName();
+    std::vector<G4String>::iterator itr = std::find( materials.begin(), materials.end(), material );
+    if( itr==materials.end() ){
+        return;
+    }
+
+    size_t m = itr - materials.begin();
+    G4double E = step->GetPreStepPoint()->GetKineticEnergy()/keV;
+    G4double length = step->GetStepLength()/cm;
+    G4double w = step->GetPreStepPoint()->GetWeight();
+
+    for( size_t l=0; l<lines.size(); l++ ){
+        G4double halfWidth = window*lines[l];
+        if( std::fabs( E-lines[l] ) < halfWidth ){
+            score[ m*lines.size()+l ] += w*length/( 2*halfWidth );
+        }
+    }
+}
+
+
+void AdjointScorer::Fill( const G4Event* event ){
+
+    Eadj = 0;
+    weight = 0;
+
+    if( event->GetNumberOfPrimaryVertex()>0 && event->GetPrimaryVertex()->GetPrimary()!=0 ){
+        Eadj = event->GetPrimaryVertex()->GetPrimary()->GetKineticEnergy()/keV;
+        weight = event->GetPrimaryVertex()->GetPrimary()->GetWeight();
+    }
+
+    for( size_t i=0; i<score.size(); i++ ){
+        rate[i] = emission[i]*score[i];
+    }
+
+    if( tree!=0 ){
+        tree->Fill();
+    }
+
+    std::fill( score.begin(), score.end(), 0. );
+}
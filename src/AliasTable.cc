@@ -0,0 +1,100 @@
+/// \file AliasTable.cc
+/// \brief Implementation of the AliasTable class (Vose's construction)
+
+#include "AliasTable.hh"
+
+#include "Randomize.hh"
+
+
+AliasTable::AliasTable() : total(0) {}
+
+
+void AliasTable::Clear(){
+    probability.clear();
+    alias.clear();
+    total = 0;
+}
+
+
+void AliasTable::Build( const std::vector<G4double>& weights ){
+
+    Clear();
+
+    size_t n = weights.size();
+    if( n==0 ){
+        return;
+    }
+
+    for( size_t i=0; i<n; i++ ){
+        total += weights[i] > 0 ? weights[i] : 0;
+    }
+    if( total<=0 ){
+        G4cerr << "AliasTable::Build : weights sum up to zero." << G4endl;
+        return;
+    }
+
+    probability.resize( n );
+    alias.resize( n );
+
+    // Scale the weights so that the average is 1
+    // and separate them into under-full and over-full entries.
+    //
+    std::vector<G4double> scaled( n );
+    std::vector<size_t> small;
+    std::vector<size_t> large;
+
+    for( size_t i=0; i<n; i++ ){
+        scaled[i] = ( weights[i] > 0 ? weights[i] : 0 ) * n / total;
+        if( scaled[i] < 1 ){
+            small.push_back( i );
+        }
+        else{
+            large.push_back( i );
+        }
+    }
+
+    // Fill each under-full entry with the excess of an over-full one.
+    //
+    while( !small.empty() && !large.empty() ){
+
+        size_t s = small.back();
+        small.pop_back();
+        size_t l = large.back();
+
+        probability[s] = scaled[s];
+        alias[s] = l;
+
+        scaled[l] = ( scaled[l] + scaled[s] ) - 1;
+        if( scaled[l] < 1 ){
+            large.pop_back();
+            small.push_back( l );
+        }
+    }
+
+    // Remaining entries are full up to rounding errors.
+    //
+    for( size_t i=0; i<large.size(); i++ ){
+        probability[ large[i] ] = 1;
+        alias[ large[i] ] = large[i];
+    }
+    for( size_t i=0; i<small.size(); i++ ){
+        probability[ small[i] ] = 1;
+        alias[ small[i] ] = small[i];
+    }
+}
+
+
+size_t AliasTable::Sample() const {
+
+    size_t n = probability.size();
+
+    // One random number selects both the column and the coin flip.
+    //
+    G4double u = G4UniformRand() * n;
+    size_t i = static_cast<size_t>( u );
+    if( i>=n ){
+        i = n-1;
+    }
+
+    return ( u-i < probability[i] ) ? i : alias[i];
+}
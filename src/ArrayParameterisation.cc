@@ -0,0 +1,36 @@
+/// \file ArrayParameterisation.cc
+/// \brief Implementation of the ArrayParameterisation class
+
+#include "ArrayParameterisation.hh"
+
+#include "G4VPhysicalVolume.hh"
+
+
+
+ArrayParameterisation::ArrayParameterisation( G4int nx, G4int ny, G4int nz, G4ThreeVector pitch, G4ThreeVector centre, G4RotationMatrix* rot ) :
+    G4VPVParameterisation(), fPitch( pitch ), fCentre( centre ), fRotation( rot ){
+
+    fN[0] = nx;
+    fN[1] = ny;
+    fN[2] = nz;
+}
+
+
+
+G4ThreeVector ArrayParameterisation::GetPosition( G4int copyNo ) const {
+
+    G4int ix = copyNo % fN[0];
+    G4int iy = ( copyNo / fN[0] ) % fN[1];
+    G4int iz = copyNo / ( fN[0]*fN[1] );
+
+    return fCentre + G4ThreeVector( ( ix - (fN[0]-1)/2. ) * fPitch.x(),
+                                    ( iy - (fN[1]-1)/2. ) * fPitch.y(),
+                                    ( iz - (fN[2]-1)/2. ) * fPitch.z() );
+}
+
+
+
+void ArrayParameterisation::ComputeTransformation( const G4int copyNo, G4VPhysicalVolume* physVol ) const {
+    physVol->SetTranslation( GetPosition( copyNo ) );
+    physVol->SetRotation( fRotation );
+}
@@ -0,0 +1,165 @@
+/// \file AssemblyRegistry.cc
+/// \brief Implementation of the AssemblyRegistry class
+
+#include "AssemblyRegistry.hh"
+#include "ArrayParameterisation.hh"
+
+#include "G4Box.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4PVReplica.hh"
+#include "G4PVParameterised.hh"
+#include "G4VisAttributes.hh"
+
+#include "G4SystemOfUnits.hh"
+
+
+AssemblyRegistry* AssemblyRegistry::registry = 0;
+
+
+AssemblyRegistry* AssemblyRegistry::Get(){
+    if( !registry ){
+        registry = new AssemblyRegistry();
+    }
+    return registry;
+}
+
+
+
+void AssemblyRegistry::Register( G4String name, std::function< G4LogicalVolume*() > builder ){
+    builders[name] = builder;
+    volumes.erase( name );
+}
+
+
+
+void AssemblyRegistry::Unregister( G4String name ){
+    builders.erase( name );
+    volumes.erase( name );
+    copies.erase( name );
+}
+
+
+
+G4LogicalVolume* AssemblyRegistry::GetLogicalVolume( G4String name ){
+
+    auto itr = volumes.find( name );
+    if( itr!=volumes.end() ){
+        return itr->second;
+    }
+
+    auto builder = builders.find( name );
+    if( builder==builders.end() ){
+        G4cerr << GetClassName() << ": assembly " << name << " is not registered." << G4endl;
+        return 0;
+    }
+
+    G4cout << GetClassName() << ": building assembly " << name << G4endl;
+
+    G4LogicalVolume* lv = builder->second();
+    volumes[name] = lv;
+    copies[name] = 0;
+
+    return lv;
+}
+
+
+
+G4VPhysicalVolume* AssemblyRegistry::Place( G4String name, G4LogicalVolume* mother, G4ThreeVector pos, G4RotationMatrix* rot, G4bool checkOverlaps, G4String pvName ){
+
+    G4LogicalVolume* lv = GetLogicalVolume( name );
+    if( lv==0 ){
+        return 0;
+    }
+
+    return new G4PVPlacement( rot, pos, lv, pvName=="" ? name : pvName, mother, false, copies[name]++, checkOverlaps );
+}
+
+
+
+G4VPhysicalVolume* AssemblyRegistry::PlaceArray( G4LogicalVolume* lv, G4String name, G4LogicalVolume* mother,
+                                                 G4int nx, G4int ny, G4int nz, G4ThreeVector pitch, G4ThreeVector centre,
+                                                 G4RotationMatrix* rot, G4String mode, G4bool checkOverlaps ){
+
+    if( nx<1 || ny<1 || nz<1 ){
+        G4cerr << GetClassName() << ": array " << name << " has no copies." << G4endl;
+        return 0;
+    }
+
+    G4int n[3] = { nx, ny, nz };
+
+    // Pitch along axes without one, e.g. a single layer, is the extent of the volume.
+    //
+    G4ThreeVector min, max;
+    lv->GetSolid()->BoundingLimits( min, max );
+    for( int i=0; i<3; i++ ){
+        if( pitch[i]<=0 ){
+            pitch[i] = max[i] - min[i];
+        }
+    }
+
+    G4cout << GetClassName() << ": placing " << nx << " x " << ny << " x " << nz << " copies of " << lv->GetName()
+        << " in " << mother->GetName() << " at " << centre/cm << " cm with pitch " << pitch/cm << " cm as " << mode << G4endl;
+
+    if( mode=="parameterised" ){
+        auto param = new ArrayParameterisation( nx, ny, nz, pitch, centre, rot );
+        return new G4PVParameterised( name, lv, mother, kUndefined, param->GetNumberOfCopies(), param, checkOverlaps );
+    }
+
+    if( mode=="replica" ){
+
+        // Replicas must fill their mother, so the array is a container of the mother material sliced along x,
+        // each slice along y and each of these along z; the volume sits in the centre of the innermost cell.
+        //
+        G4Material* fill = mother->GetMaterial();
+
+        auto solidArray = new G4Box( name+"_array", n[0]*pitch.x()/2, n[1]*pitch.y()/2, n[2]*pitch.z()/2 );
+        auto logicArray = new G4LogicalVolume( solidArray, fill, name+"_array" );
+        auto physArray = new G4PVPlacement( rot, centre, logicArray, name+"_array", mother, false, 0, checkOverlaps );
+
+        auto solidX = new G4Box( name+"_x", pitch.x()/2, n[1]*pitch.y()/2, n[2]*pitch.z()/2 );
+        auto logicX = new G4LogicalVolume( solidX, fill, name+"_x" );
+        new G4PVReplica( name+"_x", logicX, logicArray, kXAxis, n[0], pitch.x() );
+
+        auto solidY = new G4Box( name+"_y", pitch.x()/2, pitch.y()/2, n[2]*pitch.z()/2 );
+        auto logicY = new G4LogicalVolume( solidY, fill, name+"_y" );
+        new G4PVReplica( name+"_y", logicY, logicX, kYAxis, n[1], pitch.y() );
+
+        auto solidZ = new G4Box( name+"_z", pitch.x()/2, pitch.y()/2, pitch.z()/2 );
+        auto logicZ = new G4LogicalVolume( solidZ, fill, name+"_z" );
+        new G4PVReplica( name+"_z", logicZ, logicY, kZAxis, n[2], pitch.z() );
+
+        new G4PVPlacement( 0, G4ThreeVector(), lv, name, logicZ, false, 0, checkOverlaps );
+
+        auto invisible = new G4VisAttributes();
+        invisible->SetVisibility( false );
+        logicArray->SetVisAttributes( invisible );
+        logicX->SetVisAttributes( invisible );
+        logicY->SetVisAttributes( invisible );
+        logicZ->SetVisAttributes( invisible );
+
+        return physArray;
+    }
+
+    if( mode!="placement" ){
+        G4cerr << GetClassName() << ": unknown array mode " << mode << ", using placement." << G4endl;
+    }
+
+    ArrayParameterisation grid( nx, ny, nz, pitch, centre, rot );
+
+    G4VPhysicalVolume* first = 0;
+    for( G4int i=0; i<grid.GetNumberOfCopies(); i++ ){
+        G4VPhysicalVolume* pv = new G4PVPlacement( rot, grid.GetPosition( i ), lv, name, mother, false, i, checkOverlaps );
+        if( first==0 ){
+            first = pv;
+        }
+    }
+    return first;
+}
+
+
+
+void AssemblyRegistry::Clear(){
+    volumes.clear();
+    copies.clear();
+}
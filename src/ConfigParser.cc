@@ -83,6 +83,7 @@ int ConfigParser::LoadFile( const string& filename ){
     string key, val;        // to hold parameter name and value
 
     string cur_dir = GetCurrentDir( directory );  // vector to keep track of current directory
+    string start_dir = cur_dir;     // an included file is loaded under the directory of $include and should end there
 
     while(file.good()){
 
@@ -123,6 +124,15 @@ int ConfigParser::LoadFile( const string& filename ){
         else if( key=="$include" ){     // $include can be used to add parameters of another file under current directory.
             val = GetQuotedString( file);
             // file >> val;
+            size_t first = val.find_first_not_of('"');
+            size_t last = val.find_last_not_of('"');
+            val = first==string::npos ? "" : val.substr( first, last-first+1 );
+
+            // relative paths that do not exist from the working directory are taken relative to the including file
+            size_t slash = filename.rfind('/');
+            if( !val.empty() && val[0]!='/' && slash!=string::npos && !ifstream( val.c_str() ).good() )
+                val = filename.substr( 0, slash+1 ) + val;
+
             LoadFile(val);
         }
 
@@ -175,7 +185,7 @@ int ConfigParser::LoadFile( const string& filename ){
     	}   // at this point one line of parameter should have been added to config parser map.
     }
 
-    if(cur_dir!="/"){
+    if(cur_dir!=start_dir){
         G4cerr << "Error: parameter directory didn't close." << G4endl;
         Clear();
         return -1;
@@ -0,0 +1,242 @@
+/// \file DecayChainSampler.cc
+/// \brief Implementation of the DecayChainSampler class
+
+#include "DecayChainSampler.hh"
+
+#include "G4RadioactiveDecay.hh"
+#include "G4RadioactiveDecayMode.hh"
+#include "G4NuclearDecay.hh"
+#include "G4DecayTable.hh"
+#include "G4ProcessTable.hh"
+#include "G4GenericIon.hh"
+#include "G4IonTable.hh"
+#include "G4Ions.hh"
+#include "G4NistManager.hh"
+
+#include <cctype>
+#include <sstream>
+
+
+DecayChainSampler::DecayChainSampler() : decay(0), emittersOnly(false) {}
+
+
+G4ParticleDefinition* DecayChainSampler::GetIon( G4String isotope ){
+
+    // Split e.g. U238 into element symbol and mass number.
+    //
+    size_t pos = 0;
+    while( pos<isotope.size() && std::isalpha( isotope[pos] ) ){
+        pos++;
+    }
+    G4String symbol = isotope.substr( 0, pos );
+    G4int A = std::atoi( isotope.substr( pos ).c_str() );
+    G4int Z = G4NistManager::Instance()->GetZ( symbol );
+
+    if( Z<=0 || A<=0 ){
+        return 0;
+    }
+
+    return G4IonTable::GetIonTable()->GetIon( Z, A, 0. );
+}
+
+
+bool DecayChainSampler::Build( G4String isotope ){
+
+    members.clear();
+    activity.clear();
+    gammaEmitter.clear();
+    betaEmitter.clear();
+    table.Clear();
+
+    // Radioactive decay process is registered by the physics list under one of these names.
+    //
+    G4ProcessTable* processTable = G4ProcessTable::GetProcessTable();
+    decay = dynamic_cast<G4RadioactiveDecay*>( processTable->FindProcess( "Radioactivation", G4GenericIon::GenericIon() ) );
+    if( decay==0 ){
+        decay = dynamic_cast<G4RadioactiveDecay*>( processTable->FindProcess( "RadioactiveDecay", G4GenericIon::GenericIon() ) );
+    }
+    if( decay==0 ){
+        G4cerr << "DecayChainSampler: radioactive decay process not found. Was /run/initialize called?" << G4endl;
+        return false;
+    }
+
+    G4ParticleDefinition* top = GetIon( isotope );
+    if( top==0 ){
+        G4cerr << "DecayChainSampler: cannot interpret isotope " << isotope << G4endl;
+        return false;
+    }
+
+    Walk( top, 1., -1, 0 );
+
+    BuildTable();
+
+    if( table.empty() ){
+        G4cerr << "DecayChainSampler: no member to sample in the chain of " << isotope << G4endl;
+        return false;
+    }
+
+    std::vector<G4String> summary = GetSummary();
+    G4cout << "DecayChainSampler: chain of " << isotope << " in secular equilibrium" << G4endl;
+    for( size_t i=0; i<summary.size(); i++ ){
+        G4cout << '\t' << summary[i] << G4endl;
+    }
+
+    return true;
+}
+
+
+G4int DecayChainSampler::AddMember( G4ParticleDefinition* nucleus, G4double fraction ){
+
+    // The same member can be reached through different branches, e.g. Bi212 -> Po212/Tl208 -> Pb208.
+    //
+    for( size_t i=0; i<members.size(); i++ ){
+        if( members[i]==nucleus ){
+            activity[i] += fraction;
+            return i;
+        }
+    }
+
+    members.push_back( nucleus );
+    activity.push_back( fraction );
+    gammaEmitter.push_back( false );
+    betaEmitter.push_back( false );
+
+    return members.size()-1;
+}
+
+
+void DecayChainSampler::Walk( G4ParticleDefinition* nucleus, G4double fraction, G4int member, G4int depth ){
+
+    if( nucleus==0 || fraction<1.e-12 || depth>100 ){
+        return;
+    }
+
+    G4Ions* ion = dynamic_cast<G4Ions*>( nucleus );
+    if( ion==0 ){
+        return;
+    }
+
+    G4int Z = ion->GetAtomicNumber();
+    G4int A = ion->GetAtomicMass();
+    G4double excitation = ion->GetExcitationEnergy();
+
+    G4DecayTable* decayTable = decay->GetDecayTable( nucleus );
+
+    // A ground-state nucleus starts a new member unless it is stable, i.e. has no decay channel.
+    // Excited states decay within the event of the member that produced them.
+    //
+    if( excitation<=0 ){
+        if( decayTable==0 || decayTable->entries()==0 ){
+            return;
+        }
+        member = AddMember( nucleus, fraction );
+    }
+
+    if( decayTable==0 || decayTable->entries()==0 ){
+        if( excitation>0 ){
+            gammaEmitter[member] = true;
+            Walk( G4IonTable::GetIonTable()->GetIon( Z, A, 0. ), fraction, member, depth+1 );
+        }
+        return;
+    }
+
+    G4double sumBR = 0;
+    for( G4int i=0; i<decayTable->entries(); i++ ){
+        sumBR += decayTable->GetDecayChannel(i)->GetBR();
+    }
+    if( sumBR<=0 ){
+        return;
+    }
+
+    for( G4int i=0; i<decayTable->entries(); i++ ){
+
+        G4NuclearDecay* channel = dynamic_cast<G4NuclearDecay*>( decayTable->GetDecayChannel(i) );
+        if( channel==0 ){
+            continue;
+        }
+
+        G4double branch = fraction * channel->GetBR() / sumBR;
+
+        G4int daughterZ = Z;
+        G4int daughterA = A;
+
+        switch( channel->GetDecayMode() ){
+            case IT:
+                break;
+            case BetaMinus:
+                daughterZ = Z+1;
+                betaEmitter[member] = true;
+                break;
+            case BetaPlus:
+                daughterZ = Z-1;
+                betaEmitter[member] = true;
+                break;
+            case KshellEC:
+            case LshellEC:
+            case MshellEC:
+            case NshellEC:
+                daughterZ = Z-1;
+                break;
+            case Alpha:
+                daughterZ = Z-2;
+                daughterA = A-4;
+                break;
+            default:
+                // rare modes such as spontaneous fission terminate the chain here
+                continue;
+        }
+
+        G4double daughterExcitation = channel->GetDaughterExcitation();
+        if( channel->GetDecayMode()==IT && daughterExcitation>=excitation ){
+            daughterExcitation = 0;
+        }
+        if( channel->GetDecayMode()==IT || daughterExcitation>0 ){
+            gammaEmitter[member] = true;
+        }
+
+        Walk( G4IonTable::GetIonTable()->GetIon( daughterZ, daughterA, daughterExcitation ), branch, member, depth+1 );
+    }
+}
+
+
+void DecayChainSampler::SetEmittersOnly( bool a ){
+    emittersOnly = a;
+    if( !members.empty() ){
+        BuildTable();
+    }
+}
+
+
+void DecayChainSampler::BuildTable(){
+
+    std::vector<G4double> weights( members.size(), 0 );
+
+    for( size_t i=0; i<members.size(); i++ ){
+        if( emittersOnly==false || gammaEmitter[i] || betaEmitter[i] ){
+            weights[i] = activity[i];
+        }
+    }
+
+    table.Build( weights );
+}
+
+
+G4ParticleDefinition* DecayChainSampler::Sample(){
+    return members[ table.Sample() ];
+}
+
+
+std::vector<G4String> DecayChainSampler::GetSummary(){
+
+    std::vector<G4String> summary;
+
+    for( size_t i=0; i<members.size(); i++ ){
+        std::stringstream ss;
+        ss << members[i]->GetParticleName() << ' ' << members[i]->GetPDGEncoding() << ' ' << activity[i]
+            << ' ' << gammaEmitter[i] << ' ' << betaEmitter[i]
+            << ' ' << ( emittersOnly==false || gammaEmitter[i] || betaEmitter[i] );
+        summary.push_back( ss.str() );
+    }
+
+    return summary;
+}
@@ -0,0 +1,129 @@
+/// \file EarlyAbort.cc
+/// \brief Implementation of the EarlyAbort class
+
+#include "EarlyAbort.hh"
+
+#include "G4Track.hh"
+#include "G4Ions.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LossTableManager.hh"
+
+#include <algorithm>
+
+
+void EarlyAbort::BeginOfEvent(){
+    reachable.clear();
+    nReachable = 0;
+    targetHit = false;
+}
+
+
+bool EarlyAbort::RangeChecked( const G4ParticleDefinition* def ){
+
+    if( def->GetPDGCharge()==0 || def->GetPDGEncoding()<0 ){
+        return false;
+    }
+
+    // Nuclei that can decay may emit gammas towards the target.
+    //
+    const G4Ions* ion = dynamic_cast<const G4Ions*>( def );
+    if( ion!=0 && ion->GetExcitationEnergy()>0 ){
+        return false;
+    }
+
+    // Stability is decided by the lifetime rather than the stable flag, which is also set for
+    // radioactive ground-state nuclei. Stable particles have a negative lifetime in Geant4.
+    //
+    return def->GetPDGLifeTime()<0;
+}
+
+
+bool EarlyAbort::MayReach( const G4Track* track, const G4MaterialCutsCouple* couple ){
+
+    if( RangeChecked( track->GetDefinition() )==false || targets==0 || targets->empty() || couple==0 ){
+        return true;
+    }
+
+    G4double range = G4LossTableManager::Instance()->GetRange( track->GetDefinition(), track->GetKineticEnergy(), couple );
+
+    return range >= targets->Distance( track->GetPosition() );
+}
+
+
+// Couple is set only when the track starts. Before that it is taken from the volume of the track, if known.
+// Primaries have no volume yet; they are assumed to reach the target and re-evaluated at their first step.
+//
+const G4MaterialCutsCouple* EarlyAbort::GetCouple( const G4Track* track ){
+
+    if( track->GetMaterialCutsCouple()!=0 ){
+        return track->GetMaterialCutsCouple();
+    }
+    if( track->GetTouchableHandle() && track->GetVolume()!=0 ){
+        return track->GetVolume()->GetLogicalVolume()->GetMaterialCutsCouple();
+    }
+    return 0;
+}
+
+
+void EarlyAbort::NewTrack( const G4Track* track ){
+
+    bool may = MayReach( track, GetCouple( track ) );
+
+    reachable[ track->GetTrackID() ] = may;
+    if( may ){
+        nReachable++;
+    }
+}
+
+
+void EarlyAbort::ForgetTrack( const G4Track* track ){
+
+    auto itr = reachable.find( track->GetTrackID() );
+    if( itr!=reachable.end() ){
+        if( itr->second ){
+            nReachable--;
+        }
+        reachable.erase( itr );
+    }
+}
+
+
+void EarlyAbort::Step( const G4Track* track, bool hit ){
+
+    if( hit ){
+        targetHit = true;
+    }
+
+    // Only charged particles lose the ability to reach the target while travelling.
+    //
+    auto itr = reachable.find( track->GetTrackID() );
+    if( itr==reachable.end() || itr->second==false ){
+        return;
+    }
+
+    if( MayReach( track, track->GetMaterialCutsCouple() )==false ){
+        itr->second = false;
+        nReachable--;
+    }
+}
+
+
+bool EarlyAbort::EndOfTrack( const G4Track* track, const G4TrackVector* secondaries ){
+
+    ForgetTrack( track );
+
+    if( targetHit==true || nReachable>0 ){
+        return false;
+    }
+
+    if( secondaries!=0 ){
+        for( size_t i=0; i<secondaries->size(); i++ ){
+            if( MayReach( (*secondaries)[i], GetCouple( (*secondaries)[i] ) ) ){
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
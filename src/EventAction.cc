@@ -10,12 +10,14 @@
 
 #include "G4RunManager.hh"
 #include "G4Event.hh"
+#include "G4Run.hh"
 #include "G4UnitsTable.hh"
 
 #include "Randomize.hh"
 #include <iomanip>
 
 #include "StepInfo.hh"
+#include "EventInformation.hh"
 #include "G4ThreeVector.hh"
 
 #include "TTree.h"
@@ -60,6 +62,7 @@ void EventAction::BeginOfEventAction(const G4Event*){
 
             // information about its order in the event/run sequence
             //
+            data_tree->Branch("runID", &runID, "runID/I");
             data_tree->Branch("eventID", &eventID, "eventID/I");
             data_tree->Branch("trackID", &trackID, "trackID/I");
 
@@ -88,8 +91,22 @@ void EventAction::BeginOfEventAction(const G4Event*){
             data_tree->Branch("Eki", &Eki, "Eki/D"); // initial kinetic energy before the step
             data_tree->Branch("Ekf", &Ekf, "Ekf/D"); // final kinetic energy after the step
             data_tree->Branch("Edep", &Edep, "Edep/D"); // energy deposit calculated by Geant4
+            data_tree->Branch("Wi", &Wi, "Wi/D"); // track weight before the step
+            data_tree->Branch("Wf", &Wf, "Wf/D"); // track weight after the step, differs from Wi when biasing is applied
 
             data_tree->Branch("process", processName, "process[16]/C");
+
+            // photoelectrons, only when a light collection map is applied
+            //
+            if( fRunAction->GetLightCollectionMap()!=0 ){
+                data_tree->Branch("Npe", &Npe, "Npe/I");
+            }
+
+            // information about the source generating the event
+            //
+            data_tree->Branch("source", &sourceCode, "source/I");
+            data_tree->Branch("sourceWeight", &sourceWeight, "sourceWeight/D");
+            data_tree->Branch("parentEventID", &parentEventID, "parentEventID/I");
         }
     }
 
@@ -126,6 +143,18 @@ void EventAction::EndOfEventAction(const G4Event* event){
         
         if( record==true ){
 
+            runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+            sourceCode = 0;
+            sourceWeight = 1;
+            parentEventID = -1;
+
+            EventInformation* info = dynamic_cast<EventInformation*>( event->GetUserInformation() );
+            if( info!=0 ){
+                sourceCode = info->GetSourceCode();
+                sourceWeight = info->GetSourceWeight();
+                parentEventID = info->GetParentEventID();
+            }
+
             for( size_t i=0; i < stepCollection.size()-1; ++i ){
                 
                 // If process name is newEvent or timeReset, it means the end of previous event and one should write all the output.
@@ -4,6 +4,7 @@
     Contact: suerfu@berkeley.edu
 */
 #include "FarsideDetector.hh"
+#include "AssemblyRegistry.hh"
 
 #include "G4Tubs.hh"
 #include "G4LogicalVolume.hh"
@@ -12,26 +13,39 @@
 FarsideDetector::FarsideDetector( GeometryManager* gm ) : fGeometryManager( gm ){
     radius = 5 * cm;
     height = 10 * cm;
+
+    // The detector is built once and shared by all placements.
+    //
+    AssemblyRegistry::Get()->Register( "FarsideDetector", [this](){ return BuildLogicalVolume(); } );
 }
 
-void FarsideDetector::PlaceDetector( G4String name, G4ThreeVector pos, G4RotationMatrix* rot){
+FarsideDetector::~FarsideDetector(){
+    // The builder refers to this object.
+    AssemblyRegistry::Get()->Unregister( "FarsideDetector" );
+}
+
+G4LogicalVolume* FarsideDetector::BuildLogicalVolume(){
 
-    G4LogicalVolume* mother = fGeometryManager->GetLogicalVolume("world");
     G4Material* mat = fGeometryManager->GetMaterial( "G4_Pb" );
+    if( mat==0 ){
+        G4cerr << "Cannot find the material of farside detector" << G4endl;
+        return 0;
+    }
+
+    G4Tubs* solid = new G4Tubs( "FarsideDetector_solid", 0, radius, height/2, 0, CLHEP::twopi);
+    return new G4LogicalVolume( solid, mat, "FarsideDetector_lv" );
+}
+
+void FarsideDetector::PlaceDetector( G4String name, G4ThreeVector pos, G4RotationMatrix* rot){
+
+    G4LogicalVolume* mother = fGeometryManager->GetLogicalVolume("World");
 
-    if( mother!=0 && mat!=0 ){
-        G4cout << "Building farside detector " << name << G4endl;
-        G4Tubs* solid = new G4Tubs( name+"_solid", 0, radius, height/2, 0, CLHEP::twopi);
-        G4LogicalVolume* lv = new G4LogicalVolume( solid, mat, name+"_lv" );
-        new G4PVPlacement( rot, pos, lv, name, mother, false, 0, false );
+    if( mother!=0 ){
+        G4cout << "Placing farside detector " << name << G4endl;
+        AssemblyRegistry::Get()->Place( "FarsideDetector", mother, pos, rot, false, name );
     }
     else{
-        if( mother==0 ){
-            G4cerr << "Mother volume world is not defined" << G4endl;
-        }
-        else{
-            G4cerr << "Cannot find the material of farside detector" << G4endl;
-        }
+        G4cerr << "Mother volume World is not defined" << G4endl;
     }
 
 }
@@ -9,15 +9,21 @@
 
 #include "GeneratorAction.hh"
 #include "GeneratorMessenger.hh"
+#include "EventInformation.hh"
 
 #include "G4RunManager.hh"
 #include "G4ParticleGun.hh"
 #include "G4GeneralParticleSource.hh"
 #include "G4SPSPosDistribution.hh"
+#include "G4SPSEneDistribution.hh"
+#include "G4SPSAngDistribution.hh"
 #include "G4PhysicalVolumeStore.hh"
 #include "G4VisExtent.hh"
-
-#include "TKey.h"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4Event.hh"
+#include "G4RotationMatrix.hh"
+#include "Randomize.hh"
 
 // Standard includes
 #include <algorithm>
@@ -33,25 +39,34 @@ GeneratorAction::GeneratorAction( RunAction* runAction ) : G4VUserPrimaryGenerat
     fgun = new G4ParticleGun();
     fgps = new G4GeneralParticleSource();
 
-    file = 0;
     particle = "geantino";
 
-    useGPS = true;
+    fMode = kGPS;
 	GPSInMaterial = false;
 		// default values.
 
-    primaryGeneratorMessenger = new GeneratorMessenger( this );
+    geometryVersion = GeometryManager::Get()->GetGeometryVersion();
+
+    useDecayChain = false;
+    energyOverridden = false;
+
+    phaseSpaceFile = 0;
+    phaseSpaceTree = 0;
+    phaseSpaceEntry = 0;
+    phaseSpaceRecycle = 1;
+    phaseSpaceRecycled = 0;
+    phaseSpaceRotation = false;
+    phaseSpaceTranslation = G4ThreeVector(0,0,0);
 
-    fVolumesInMaterial.clear();
-    fCumulativeMaterialVolume = 0;
+    primaryGeneratorMessenger = new GeneratorMessenger( this );
 }
 
 
 GeneratorAction::~GeneratorAction(){
 
-    if( !file==0 ){
-        file->Close();
-        delete file;
+    if( phaseSpaceFile!=0 ){
+        phaseSpaceFile->Close();
+        delete phaseSpaceFile;
     }
 
     delete primaryGeneratorMessenger;
@@ -62,42 +77,17 @@ void GeneratorAction::SetSpectrum( G4String str ){
 
     G4cout << "Setting generator spectrum to " << str << G4endl;
 
-    // If a file is already opened, close it first.
-    if( file!=0 && file->IsOpen() ){
-        file->Close();
-    }
-
-    G4cout << "Opening " << str << G4endl;
-
-    // open in read mode (default)
-    file = new TFile( str.c_str() );
-    if( !file->IsOpen() ){
-        G4cerr << "Error opening " << s << G4endl;
-        return;
-    }
-
-    // Note: the spectrum file should contain only one 2D histogram
-    // The histogram should have energy (in keV) and polar angle (in rad) as x and y coordinates.
+    // The histograms are converted into sampling tables and the file is closed.
     //
-    TIter next( file->GetListOfKeys() );
-
-    TString T2HF_name;
-    TKey *key;
-    while( (key=(TKey*)next()) ) {
-        T2HF_name=key->GetName();
+    if( spectrum.Load( str )==false ){
+        throw std::runtime_error( "Generator::SetSpectrum cannot load spectrum from '" + str + "'" );
     }
-    hist2D = (TH2F*)file->Get(T2HF_name);
+
+    ResetMode();
 
 	// When this function is called, particle gun should be used instead of GPS
 	// set the corresponding flag variable.
-    useGPS = false;
-}
-
-
-// Set the energy from the histogram to have the correct unit.
-//
-G4double GeneratorAction::SetEnergy( double E ){
-    return E * keV;
+    fMode = kSpectrum;
 }
 
 
@@ -111,109 +101,441 @@ void GeneratorAction::SetParticleName( G4String str ){
 // 
 void GeneratorAction::GPSSetMaterial( G4String materialName ){
     
-    fVolumesInMaterial.clear();
-        // clear the previous material mass information.
-    
-    fCumulativeMaterialVolume = 0;
-        // this variable contains the total mass of the material of concern.
-
     G4cout<<"Generator setting material to be " << materialName << G4endl;
 
-    // Iterate over all physical volumes and add the mass of volumes with matching material.
+    this->materialName = materialName;
+    fVolumesInMaterial = FindVolumes( materialName, true );
+    geometryVersion = GeometryManager::Get()->GetGeometryVersion();
+
+    if( fVolumesInMaterial.volumes.empty() ){
+        G4cout << "Generator::GPSInMaterial::SetMaterial did not find volume made of '" + materialName + "'" << G4endl;
+        throw std::runtime_error("Generator::GPSInMaterial::SetMaterial did not find volume made of '" + materialName + "'");
+    }
+
+    // The decay chain is sampled in the material, otherwise the GPS energy set by macro is used again.
     //
+    if( useDecayChain==false ){
+        RestoreEnergy();
+    }
+
+	// Set the correct flags.
+    fMode = kGPS;
+    GPSInMaterial = true;
+}
+
+
+// Iterate over all physical volumes and accumulate the mass of volumes with matching material.
+// Masses are computed once here so that picking a volume in each event is a binary search.
+//
+GeneratorAction::VolumeGroup GeneratorAction::FindVolumes( G4String target, G4bool materialOnly ){
+
+    VolumeGroup group;
+
     G4PhysicalVolumeStore *PVStore = G4PhysicalVolumeStore::GetInstance();
-    
-    G4int i = 0;
 
-    while( i<(G4int)PVStore->size() ){
+    G4double sum = 0;
+    for( size_t i=0; i<PVStore->size(); i++ ){
 
         G4VPhysicalVolume* pv = (*PVStore)[i];
 
-        G4cout << "Checking " << pv->GetName() << G4endl;
+        // Replicas, parameterised volumes and daughters of repeated mothers count once per copy.
+        //
+        if( pv->GetLogicalVolume()->GetMaterial()->GetName() == target ){
+            sum += GetCopyMass( pv );
+            group.volumes.push_back( pv );
+            group.cumulativeMass.push_back( sum );
+        }
+    }
 
-        if (pv->GetLogicalVolume()->GetMaterial()->GetName() == materialName) {
-            fVolumesInMaterial.push_back(pv);
-                //fCumulativeMaterialVolume+=pv->GetLogicalVolume()->GetSolid()->GetCubicVolume()/CLHEP::cm3;
-            fCumulativeMaterialVolume+=pv->GetLogicalVolume()->GetMass( false, false )/CLHEP::kg;
+    if( group.volumes.empty() && materialOnly==false ){
+        G4VPhysicalVolume* pv = PVStore->GetVolume( target, false );
+        if( pv!=0 ){
+            group.volumes.push_back( pv );
+            group.cumulativeMass.push_back( GetCopyMass( pv ) );
         }
+    }
+
+    return group;
+}
+
+
+void GeneratorAction::AddIsotope( G4String isotope, G4double activity, G4String target ){
 
-        i++;
+    G4cout << "Generator adding " << isotope << " with " << activity << " Bq/kg in " << target << G4endl;
+
+    IsotopeComponent component;
+    component.name = isotope;
+    component.ion = DecayChainSampler::GetIon( isotope );
+    component.activity = activity;
+    component.target = target;
+    component.group = FindVolumes( target, false );
+    geometryVersion = GeometryManager::Get()->GetGeometryVersion();
+
+    if( component.ion==0 ){
+        throw std::runtime_error( "Generator::AddIsotope cannot interpret isotope '" + isotope + "'" );
+    }
+    if( component.group.volumes.empty() ){
+        throw std::runtime_error( "Generator::AddIsotope did not find material or volume '" + target + "'" );
+    }
+    if( activity<0 ){
+        throw std::runtime_error( "Generator::AddIsotope activity of '" + isotope + "' is negative" );
     }
 
-    if( fVolumesInMaterial.empty() ){
-        G4cout << "Generator::GPSInMaterial::SetMaterial did not find volume made of '" + materialName + "'" << G4endl;
-        throw std::runtime_error("Generator::GPSInMaterial::SetMaterial did not find volume made of '" + materialName + "'");
+    isotopes.push_back( component );
+
+    UpdateIsotopeMix();
+
+    ResetMode();
+    OverrideEnergy();
+
+    fMode = kIsotopeMix;
+}
+
+
+void GeneratorAction::ClearIsotopes(){
+    isotopes.clear();
+    isotopeTable.Clear();
+    if( fMode==kIsotopeMix ){
+        RestoreEnergy();
+        fMode = kGPS;
     }
+}
 
-	// Set the correct flags.
-    useGPS = true;
-    GPSInMaterial = true;
+
+void GeneratorAction::UpdateIsotopeMix(){
+
+    std::vector<G4double> rate;
+    for( size_t i=0; i<isotopes.size(); i++ ){
+        rate.push_back( isotopes[i].activity * isotopes[i].group.GetMass() );
+    }
+    isotopeTable.Build( rate );
+
+    // Summary is stored in the output so that components can be normalized in the analysis.
+    //
+    std::vector<G4String> summary;
+    summary.push_back( "# isotope pdg activity(Bq/kg) target mass(kg) rate(Bq); total rate = " + std::to_string( isotopeTable.GetTotal() ) + " Bq" );
+    for( size_t i=0; i<isotopes.size(); i++ ){
+        std::stringstream ss;
+        ss << isotopes[i].name << ' ' << isotopes[i].ion->GetPDGEncoding() << ' ' << isotopes[i].activity << ' '
+           << isotopes[i].target << ' ' << isotopes[i].group.GetMass() << ' ' << rate[i];
+        summary.push_back( ss.str() );
+    }
+    fRunAction->SetMetadata( "isotopeMix", summary );
+}
+
+
+void GeneratorAction::SetPhaseSpace( G4String fileName ){
+
+    G4cout << "Setting generator phase space to " << fileName << G4endl;
+
+    if( phaseSpaceFile!=0 ){
+        phaseSpaceFile->Close();
+        delete phaseSpaceFile;
+        phaseSpaceFile = 0;
+        phaseSpaceTree = 0;
+    }
+
+    phaseSpaceFile = TFile::Open( fileName.c_str(), "READ" );
+    if( phaseSpaceFile==0 || !phaseSpaceFile->IsOpen() ){
+        throw std::runtime_error( "Generator::SetPhaseSpace cannot open '" + fileName + "'" );
+    }
+
+    phaseSpaceTree = (TTree*)phaseSpaceFile->Get( "phaseSpace" );
+    if( phaseSpaceTree==0 ){
+        throw std::runtime_error( "Generator::SetPhaseSpace did not find phaseSpace tree in '" + fileName + "'" );
+    }
+
+    phaseSpaceRecord.SetBranchAddress( phaseSpaceTree );
+    phaseSpaceEntry = 0;
+    phaseSpaceRecycled = 0;
+
+    G4cout << "Phase space contains " << phaseSpaceTree->GetEntries() << " particles." << G4endl;
+
+    ResetMode();
+    fMode = kPhaseSpace;
+}
+
+
+void GeneratorAction::SetDecayChain( G4String isotope ){
+
+    G4cout << "Setting generator decay chain to " << isotope << G4endl;
+
+    if( decayChain.Build( isotope )==false ){
+        throw std::runtime_error( "Generator::SetDecayChain cannot build the decay chain of '" + isotope + "'" );
+    }
+
+    // Sampled members decay at rest.
+    //
+    OverrideEnergy();
+
+    useDecayChain = true;
+    fMode = kGPS;
+
+    fRunAction->SetKillDaughterNuclei( true );
+
+    std::vector<G4String> summary = decayChain.GetSummary();
+    summary.insert( summary.begin(), "# member pdg activity gamma beta sampled; weight = " + std::to_string( decayChain.GetWeight() ) );
+    fRunAction->SetMetadata( "decayChain", summary );
+}
+
+
+void GeneratorAction::SetDecayChainEmittersOnly( G4bool a ){
+
+    decayChain.SetEmittersOnly( a );
+
+    if( useDecayChain ){
+        std::vector<G4String> summary = decayChain.GetSummary();
+        summary.insert( summary.begin(), "# member pdg activity gamma beta sampled; weight = " + std::to_string( decayChain.GetWeight() ) );
+        fRunAction->SetMetadata( "decayChain", summary );
+    }
+}
+
+
+void GeneratorAction::SetSurface( G4String volumeName ){
+
+    G4cout << "Generator setting surface source on " << volumeName << G4endl;
+
+    surfaceVolume = volumeName;
+    UpdateSurface();
+
+    ResetMode();
+    fMode = kSurface;
+}
+
+
+void GeneratorAction::ResetMode(){
+
+    if( useDecayChain ){
+        useDecayChain = false;
+        fRunAction->SetKillDaughterNuclei( false );
+    }
+    RestoreEnergy();
+}
+
+
+void GeneratorAction::OverrideEnergy(){
+
+    G4SPSEneDistribution* ed = fgps->GetCurrentSource()->GetEneDist();
+
+    if( energyOverridden==false ){
+        savedEnergyType = ed->GetEnergyDisType();
+        savedMonoEnergy = ed->GetMonoEnergy();
+        energyOverridden = true;
+    }
+
+    ed->SetEnergyDisType( "Mono" );
+    ed->SetMonoEnergy( 0 );
+}
+
+
+void GeneratorAction::RestoreEnergy(){
+
+    if( energyOverridden ){
+        G4SPSEneDistribution* ed = fgps->GetCurrentSource()->GetEneDist();
+        ed->SetEnergyDisType( savedEnergyType );
+        ed->SetMonoEnergy( savedMonoEnergy );
+        energyOverridden = false;
+    }
+}
+
+
+void GeneratorAction::SetSurfaceFaces( G4String faces ){
+
+    surfaceFaces.clear();
+
+    std::istringstream ss( faces );
+    G4String face;
+    while( ss >> face ){
+        surfaceFaces.push_back( face );
+    }
+
+    if( surfaceVolume!="" ){
+        UpdateSurface();
+    }
+}
+
+
+void GeneratorAction::UpdateSurface(){
+
+    geometryVersion = GeometryManager::Get()->GetGeometryVersion();
+
+    G4VPhysicalVolume* pv = G4PhysicalVolumeStore::GetInstance()->GetVolume( surfaceVolume, false );
+    if( pv==0 ){
+        throw std::runtime_error( "Generator::SetSurface did not find volume '" + surfaceVolume + "'" );
+    }
+
+    if( surface.Set( pv, surfaceFaces )==false ){
+        throw std::runtime_error( "Generator::SetSurface cannot use the surface of '" + surfaceVolume + "'" );
+    }
+
+    // The area is stored so that the live time can be computed without parsing the macro.
+    //
+    std::vector<G4String> summary = surface.GetSummary();
+    summary.insert( summary.begin(), "# units m2; live time = N / (J x area), J = inward current per m2 per s" );
+    fRunAction->SetMetadata( "surfaceSource", summary );
+
+    G4cout << "Surface source area is " << surface.GetArea() << " m2" << G4endl;
+}
+
+
+void GeneratorAction::UpdateVolumes(){
+
+    G4cout << "Generator finding source volumes in the rebuilt geometry..." << G4endl;
+
+    geometryVersion = GeometryManager::Get()->GetGeometryVersion();
+
+    if( GPSInMaterial ){
+        fVolumesInMaterial = FindVolumes( materialName, true );
+        if( fVolumesInMaterial.volumes.empty() ){
+            throw std::runtime_error("Generator::UpdateVolumes did not find volume made of '" + materialName + "' in the new geometry");
+        }
+    }
+
+    if( !isotopes.empty() ){
+        for( size_t i=0; i<isotopes.size(); i++ ){
+            isotopes[i].group = FindVolumes( isotopes[i].target, false );
+            if( isotopes[i].group.volumes.empty() ){
+                throw std::runtime_error( "Generator::UpdateVolumes did not find material or volume '" + isotopes[i].target + "' in the new geometry" );
+            }
+        }
+        UpdateIsotopeMix();
+    }
+
+    if( surfaceVolume!="" ){
+        UpdateSurface();
+    }
 }
 
 
 // This function randomly returns a pointer to physical volume 
 // with probability corresponding to the mass of the volume
 //
-G4VPhysicalVolume* GPSInMaterialPickVolume( double CumulativeMaterialVolume,  std::vector<G4VPhysicalVolume*> VolumesInMaterial ) {
+G4VPhysicalVolume* GeneratorAction::PickVolume( const VolumeGroup& group ){
 
-    // Generate a random variable 
-    G4double r = CLHEP::RandFlat::shoot(0.,CumulativeMaterialVolume);
-    G4int selectedVolume=0;
-    G4double sum=0;
-    do {
-        //sum+=VolumesInMaterial[selectedVolume]->GetLogicalVolume()->GetSolid()->GetCubicVolume()/CLHEP::cm3;
-        sum+=VolumesInMaterial[selectedVolume]->GetLogicalVolume()->GetMass( false, false )/CLHEP::kg;
-        ++selectedVolume;
-    } while(sum<r);
+    G4double r = CLHEP::RandFlat::shoot( 0., group.GetMass() );
 
-    return VolumesInMaterial[selectedVolume-1];
+    size_t index = std::upper_bound( group.cumulativeMass.begin(), group.cumulativeMass.end(), r ) - group.cumulativeMass.begin();
+    if( index>=group.volumes.size() ){
+        index = group.volumes.size()-1;
+    }
+
+    return group.volumes[index];
+}
+
+
+G4double GeneratorAction::GetCopyMass( G4VPhysicalVolume* pv ){
+    size_t copies = std::max( (size_t)1, GeometryManager::GetNumberOfInstances( pv ) );
+    return copies * GeometryManager::Get()->GetMass( pv->GetLogicalVolume() )/CLHEP::kg;
+}
+
+
+void GeneratorAction::ConfineToVolume( G4VPhysicalVolume* selectedVolume ){
+
+    // Copies have the same mass, so one is chosen uniformly.
+    //
+    size_t copies = GeometryManager::GetNumberOfInstances( selectedVolume );
+    size_t instance = copies>1 ? std::min( (size_t)( copies*G4UniformRand() ), copies-1 ) : 0;
+
+    // Bounding box in global coordinates, valid also for rotated volumes.
+    //
+    G4VisExtent extent = GeometryManager::GetGlobalExtent( selectedVolume, instance );
+
+    G4SPSPosDistribution* pd= fgps->GetCurrentSource()->GetPosDist();
+    pd->ConfineSourceToVolume( selectedVolume->GetName() );
+    pd->SetPosDisType( "Volume" );
+    pd->SetPosDisShape( "Para" );
+    pd->SetCentreCoords( G4ThreeVector( (extent.GetXmax()+extent.GetXmin())/2., (extent.GetYmax()+extent.GetYmin())/2., (extent.GetZmax()+extent.GetZmin())/2. ) );
+    pd->SetHalfX( (extent.GetXmax()-extent.GetXmin()) / 2. );
+    pd->SetHalfY( (extent.GetYmax()-extent.GetYmin()) / 2. );
+    pd->SetHalfZ( (extent.GetZmax()-extent.GetZmin()) / 2. );
 }
 
 
 void GeneratorAction::GeneratePrimaries( G4Event* anEvent ){
-    
+
+    // Volumes found before the geometry was rebuilt no longer exist.
+    //
+    if( GeometryManager::Get()->GetGeometryVersion()!=geometryVersion ){
+        UpdateVolumes();
+    }
+
+    // Decay stages split from previous events are generated before new primaries,
+    // so that the queue holds at most the stages of one chain.
+    //
+    DeferredStage stage;
+    if( fRunAction->PopStage( stage ) ){
+        GenerateStagePrimaries( anEvent, stage );
+        return;
+    }
+
+    // Replace the GPS particle with a member of the decay chain.
+    // The weight is the number of member decays represented by each event per decay of the top of the chain.
+    //
+    if( fMode == kGPS && useDecayChain == true ){
+        G4ParticleDefinition* member = decayChain.Sample();
+        fgps->SetParticleDefinition( member );
+        anEvent->SetUserInformation( new EventInformation( member->GetPDGEncoding(), decayChain.GetWeight() ) );
+    }
+
 	// If using particle gun, sample E and theta from the spectrum
 	//
-    if( useGPS == false ){
-        hist2D->GetRandom2( Energy, Theta );
-        fgun->SetParticleDefinition( G4ParticleTable::GetParticleTable()->FindParticle( particle ) );
-        fgun->SetParticleMomentumDirection( G4ThreeVector(0, sin(Theta), cos(Theta)) );
-        fgun->SetParticleEnergy( SetEnergy( Energy ) );
+    if( fMode == kSpectrum ){
+        G4String name = particle;
+        G4double energy;
+        G4ThreeVector direction;
+        spectrum.Sample( name, energy, direction );
+
+        fgun->SetParticleDefinition( G4ParticleTable::GetParticleTable()->FindParticle( name ) );
+        fgun->SetParticleMomentumDirection( direction );
+        fgun->SetParticleEnergy( energy );
         fgun->GeneratePrimaryVertex( anEvent );
     }
 
 	// Otherwise, if in material, get the source
 	//
-    else if ( useGPS == true && GPSInMaterial == true ) {
+    else if( fMode == kPhaseSpace ){
+        GeneratePhaseSpacePrimaries( anEvent );
+    }
 
-        if( fVolumesInMaterial.empty() ){
-            throw std::runtime_error( "Generator::GPSInMaterial::GeneratePrimaries : no material set");
-        }
+    else if( fMode == kIsotopeMix ){
 
-        G4VPhysicalVolume* selectedVolume = GPSInMaterialPickVolume( fCumulativeMaterialVolume,  fVolumesInMaterial );
+        // The ion decays at rest; its daughters are followed by radioactive decay as usual.
+        //
+        const IsotopeComponent& component = isotopes[ isotopeTable.Sample() ];
 
-        G4ThreeVector selectedVolumePosition = GeometryManager::GetGlobalPosition( selectedVolume );
+        ConfineToVolume( PickVolume( component.group ) );
 
-        G4VisExtent extent = selectedVolume->GetLogicalVolume()->GetSolid()->GetExtent();
+        fgps->SetParticleDefinition( component.ion );
+        fgps->GetCurrentSource()->GetEneDist()->SetEnergyDisType( "Mono" );
+        fgps->GetCurrentSource()->GetEneDist()->SetMonoEnergy( 0 );
+        fgps->GeneratePrimaryVertex( anEvent );
 
-        G4ThreeVector translationToVolumeCenter( (extent.GetXmax()+extent.GetXmin())/2., (extent.GetYmax()+extent.GetYmin())/2., (extent.GetZmax()+extent.GetZmin())/2. );
+        anEvent->SetUserInformation( new EventInformation( component.ion->GetPDGEncoding() ) );
+    }
 
-        G4SPSPosDistribution* pd= fgps->GetCurrentSource()->GetPosDist();
-        pd->ConfineSourceToVolume( selectedVolume->GetName() );
-        pd->SetPosDisType( "Volume" );
-        pd->SetPosDisShape( "Para" );
-        pd->SetCentreCoords( selectedVolumePosition + translationToVolumeCenter );
-        pd->SetHalfX( (extent.GetXmax()-extent.GetXmin()) / 2. );
-        pd->SetHalfY( (extent.GetYmax()-extent.GetYmin()) / 2. );
-        pd->SetHalfZ( (extent.GetZmax()-extent.GetZmin()) / 2. );
+    // Position and direction are overridden, GPS provides particle and energy.
+    //
+    else if( fMode == kSurface ){
 
-        /*
-        G4cout << "GPSInMaterial confined to volume " << selectedVolume->GetName() << G4endl;
-        G4cout << selectedVolumePosition << "\t trans. to vol center : " << translationToVolumeCenter << G4endl;
-        G4cout << "extent is " << (extent.GetXmax()-extent.GetXmin()) / 2. << ' ' 
-            << (extent.GetYmax()-extent.GetYmin()) / 2. << ' ' 
-            << (extent.GetZmax()-extent.GetZmin()) / 2. << G4endl;
-        */
+        G4ThreeVector position, direction;
+        surface.Sample( position, direction );
+
+        G4SPSPosDistribution* pd = fgps->GetCurrentSource()->GetPosDist();
+        pd->SetPosDisType( "Point" );
+        pd->SetCentreCoords( position );
+        fgps->GetCurrentSource()->GetAngDist()->SetAngDistType( "planar" );
+        fgps->GetCurrentSource()->GetAngDist()->SetParticleMomentumDirection( direction );
+
+        fgps->GeneratePrimaryVertex( anEvent );
+    }
+
+    else if ( fMode == kGPS && GPSInMaterial == true ) {
+
+        if( fVolumesInMaterial.volumes.empty() ){
+            throw std::runtime_error( "Generator::GPSInMaterial::GeneratePrimaries : no material set");
+        }
+
+        ConfineToVolume( PickVolume( fVolumesInMaterial ) );
 
         fgps->GeneratePrimaryVertex( anEvent );
     }
@@ -227,4 +549,81 @@ void GeneratorAction::GeneratePrimaries( G4Event* anEvent ){
 }
 
 
+void GeneratorAction::GeneratePhaseSpacePrimaries( G4Event* anEvent ){
+
+    Long64_t nEntries = phaseSpaceTree->GetEntries();
+
+    if( phaseSpaceEntry >= nEntries ){
+        G4cerr << "Generator::GeneratePhaseSpacePrimaries : phase space exhausted. Aborting run..." << G4endl;
+        G4RunManager::GetRunManager()->AbortRun( true );
+        return;
+    }
+
+    // The same rotation is applied to all particles of the recorded event
+    // so that their correlation is preserved.
+    //
+    G4RotationMatrix rotation;
+    if( phaseSpaceRotation ){
+        rotation.rotateZ( CLHEP::twopi*G4UniformRand() );
+    }
+
+    Long64_t entry = phaseSpaceEntry;
+    phaseSpaceTree->GetEntry( entry );
+    G4int recordedEventID = phaseSpaceRecord.GetEventID();
+
+    while( entry < nEntries ){
+
+        phaseSpaceTree->GetEntry( entry );
+        if( phaseSpaceRecord.GetEventID()!=recordedEventID ){
+            break;
+        }
+        entry++;
+
+        G4ParticleDefinition* def = phaseSpaceRecord.GetParticleDefinition();
+        if( def==0 ){
+            G4cerr << "Generator::GeneratePhaseSpacePrimaries : unknown PDG code " << phaseSpaceRecord.GetPDGCode() << ". Skipping..." << G4endl;
+            continue;
+        }
+
+        G4ThreeVector position = rotation * phaseSpaceRecord.GetPosition() + phaseSpaceTranslation;
+
+        G4PrimaryParticle* primary = new G4PrimaryParticle( def );
+        primary->SetMomentumDirection( rotation * phaseSpaceRecord.GetMomentumDir() );
+        primary->SetKineticEnergy( phaseSpaceRecord.GetEnergy() );
+        primary->SetWeight( phaseSpaceRecord.GetWeight() );
+
+        G4PrimaryVertex* vertex = new G4PrimaryVertex( position, phaseSpaceRecord.GetTime() );
+        vertex->SetPrimary( primary );
+
+        anEvent->AddPrimaryVertex( vertex );
+    }
+
+    // Move on to the next recorded event after it has been recycled enough times.
+    //
+    phaseSpaceRecycled++;
+    if( phaseSpaceRecycled >= phaseSpaceRecycle ){
+        phaseSpaceEntry = entry;
+        phaseSpaceRecycled = 0;
+    }
+}
+
+
+void GeneratorAction::GenerateStagePrimaries( G4Event* anEvent, const DeferredStage& stage ){
+
+    for( size_t i=0; i<stage.tracks.size(); i++ ){
 
+        const DeferredStage::Track& track = stage.tracks[i];
+
+        G4PrimaryParticle* primary = new G4PrimaryParticle( track.definition );
+        primary->SetMomentumDirection( track.direction );
+        primary->SetKineticEnergy( track.energy );
+        primary->SetWeight( track.weight );
+
+        G4PrimaryVertex* vertex = new G4PrimaryVertex( track.position, track.time );
+        vertex->SetPrimary( primary );
+
+        anEvent->AddPrimaryVertex( vertex );
+    }
+
+    anEvent->SetUserInformation( new EventInformation( stage.sourceCode, stage.sourceWeight, stage.parentEventID ) );
+}
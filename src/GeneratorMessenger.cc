@@ -12,6 +12,8 @@
 
 #include "GeneratorAction.hh"
 
+#include <sstream>
+
 GeneratorMessenger::GeneratorMessenger( GeneratorAction* generator ) : G4UImessenger(){
     
     primaryGenerator = generator;
@@ -33,7 +35,62 @@ GeneratorMessenger::GeneratorMessenger( GeneratorAction* generator ) : G4UImesse
 	cmdSetParticle->SetGuidance( "Set the name of the particle.");
 	cmdSetParticle->SetParameterName( "gamma", false);
 	cmdSetParticle->AvailableForStates( G4State_PreInit, G4State_Idle);
-    
+
+    cmdDecayChain = new G4UIcmdWithAString( "/generator/decayChain", this);
+    cmdDecayChain->SetGuidance( "Sample one member of the decay chain in secular equilibrium per event, e.g. U238.");
+    cmdDecayChain->SetGuidance( "Position is sampled by GPS. Ground-state daughter nuclei are not tracked.");
+    cmdDecayChain->SetParameterName( "U238", false);
+    cmdDecayChain->AvailableForStates( G4State_Idle);
+
+    cmdDecayChainEmittersOnly = new G4UIcmdWithABool( "/generator/decayChainEmittersOnly", this);
+    cmdDecayChainEmittersOnly->SetGuidance( "Sample only chain members emitting gamma or beta.");
+    cmdDecayChainEmittersOnly->SetParameterName( "emittersOnly", false);
+    cmdDecayChainEmittersOnly->AvailableForStates( G4State_PreInit, G4State_Idle);
+
+    cmdAddIsotope = new G4UIcmdWithAString( "/generator/addIsotope", this);
+    cmdAddIsotope->SetGuidance( "Add an isotope to the mixed source: isotope, activity in Bq/kg, material or volume name.");
+    cmdAddIsotope->SetGuidance( "e.g. /generator/addIsotope K40 3.2 Rock");
+    cmdAddIsotope->SetGuidance( "Isotope of each event is chosen in proportion to activity x mass and written as source.");
+    cmdAddIsotope->SetParameterName( "K40 3.2 Rock", false);
+    cmdAddIsotope->AvailableForStates( G4State_Idle);
+
+    cmdClearIsotopes = new G4UIcmdWithoutParameter( "/generator/clearIsotopes", this);
+    cmdClearIsotopes->SetGuidance( "Remove all isotopes of the mixed source.");
+    cmdClearIsotopes->AvailableForStates( G4State_PreInit, G4State_Idle);
+
+    cmdSurface = new G4UIcmdWithAString( "/generator/surface", this);
+    cmdSurface->SetGuidance( "Generate GPS particles entering a G4Box or G4Tubs volume through its surface.");
+    cmdSurface->SetGuidance( "Direction follows the cosine law about the inward normal. Area is written as surfaceSource.");
+    cmdSurface->SetParameterName( "volume", false);
+    cmdSurface->AvailableForStates( G4State_Idle);
+
+    cmdSurfaceFaces = new G4UIcmdWithAString( "/generator/surfaceFaces", this);
+    cmdSurfaceFaces->SetGuidance( "Faces used by the surface source: +x -x +y -y +z -z for a box, side +z -z for a cylinder, or all.");
+    cmdSurfaceFaces->SetParameterName( "faces", false);
+    cmdSurfaceFaces->SetDefaultValue( "all" );
+    cmdSurfaceFaces->AvailableForStates( G4State_PreInit, G4State_Idle);
+
+    cmdPhaseSpace = new G4UIcmdWithAString( "/generator/phaseSpace", this);
+    cmdPhaseSpace->SetGuidance( "Replay particles from the phaseSpace tree of a previous run.");
+    cmdPhaseSpace->SetParameterName( "foo.root", false);
+    cmdPhaseSpace->AvailableForStates( G4State_PreInit, G4State_Idle);
+
+    cmdPhaseSpaceRecycle = new G4UIcmdWithAnInteger( "/generator/phaseSpaceRecycle", this);
+    cmdPhaseSpaceRecycle->SetGuidance( "Number of times each recorded event is replayed.");
+    cmdPhaseSpaceRecycle->SetParameterName( "N", false);
+    cmdPhaseSpaceRecycle->SetRange( "N>0" );
+    cmdPhaseSpaceRecycle->AvailableForStates( G4State_PreInit, G4State_Idle);
+
+    cmdPhaseSpaceRotation = new G4UIcmdWithABool( "/generator/phaseSpaceRotation", this);
+    cmdPhaseSpaceRotation->SetGuidance( "Apply a random rotation about z-axis to each replayed event.");
+    cmdPhaseSpaceRotation->SetParameterName( "rotate", false);
+    cmdPhaseSpaceRotation->AvailableForStates( G4State_PreInit, G4State_Idle);
+
+    cmdPhaseSpaceTranslation = new G4UIcmdWith3VectorAndUnit( "/generator/phaseSpaceTranslation", this);
+    cmdPhaseSpaceTranslation->SetGuidance( "Translate replayed positions. Applied after rotation.");
+    cmdPhaseSpaceTranslation->SetParameterName( "x", "y", "z", false);
+    cmdPhaseSpaceTranslation->SetDefaultUnit( "cm" );
+    cmdPhaseSpaceTranslation->AvailableForStates( G4State_PreInit, G4State_Idle);
 }
 
 
@@ -41,6 +98,16 @@ GeneratorMessenger::~GeneratorMessenger(){
     delete cmdGPSInMaterial;
     delete cmdSetSpectrum;
     delete cmdSetParticle;
+    delete cmdDecayChain;
+    delete cmdDecayChainEmittersOnly;
+    delete cmdAddIsotope;
+    delete cmdClearIsotopes;
+    delete cmdSurface;
+    delete cmdSurfaceFaces;
+    delete cmdPhaseSpace;
+    delete cmdPhaseSpaceRecycle;
+    delete cmdPhaseSpaceRotation;
+    delete cmdPhaseSpaceTranslation;
 }
 
 
@@ -55,6 +122,44 @@ void GeneratorMessenger::SetNewValue(G4UIcommand* command, G4String newValue){
 	else if( command == cmdGPSInMaterial ){
         primaryGenerator->GPSSetMaterial( newValue );
     }
+    else if( command == cmdDecayChain ){
+        primaryGenerator->SetDecayChain( newValue );
+    }
+    else if( command == cmdDecayChainEmittersOnly ){
+        primaryGenerator->SetDecayChainEmittersOnly( cmdDecayChainEmittersOnly->GetNewBoolValue( newValue ) );
+    }
+    else if( command == cmdAddIsotope ){
+        std::istringstream ss( newValue );
+        G4String isotope, target;
+        G4double activity = -1;
+        ss >> isotope >> activity >> target;
+        if( ss.fail() ){
+            G4cerr << "Usage: /generator/addIsotope <isotope> <Bq/kg> <material or volume>" << G4endl;
+            return;
+        }
+        primaryGenerator->AddIsotope( isotope, activity, target );
+    }
+    else if( command == cmdClearIsotopes ){
+        primaryGenerator->ClearIsotopes();
+    }
+    else if( command == cmdSurface ){
+        primaryGenerator->SetSurface( newValue );
+    }
+    else if( command == cmdSurfaceFaces ){
+        primaryGenerator->SetSurfaceFaces( newValue );
+    }
+    else if( command == cmdPhaseSpace ){
+        primaryGenerator->SetPhaseSpace( newValue );
+    }
+    else if( command == cmdPhaseSpaceRecycle ){
+        primaryGenerator->SetPhaseSpaceRecycle( cmdPhaseSpaceRecycle->GetNewIntValue( newValue ) );
+    }
+    else if( command == cmdPhaseSpaceRotation ){
+        primaryGenerator->SetPhaseSpaceRotation( cmdPhaseSpaceRotation->GetNewBoolValue( newValue ) );
+    }
+    else if( command == cmdPhaseSpaceTranslation ){
+        primaryGenerator->SetPhaseSpaceTranslation( cmdPhaseSpaceTranslation->GetNew3VectorValue( newValue ) );
+    }
 
 }
 
@@ -0,0 +1,379 @@
+/// \file GeometryBuilder.cc
+/// \brief Implementation of the GeometryBuilder class
+
+#include "GeometryBuilder.hh"
+#include "GeometryManager.hh"
+#include "AssemblyRegistry.hh"
+
+#include "G4Box.hh"
+#include "G4Tubs.hh"
+#include "G4UnionSolid.hh"
+#include "G4SubtractionSolid.hh"
+#include "G4IntersectionSolid.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4Material.hh"
+
+#include "G4VisAttributes.hh"
+#include "G4Colour.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+
+
+GeometryBuilder::GeometryBuilder( ConfigParser* config, bool checkOverlaps ) : fConfig( config ), fCheckOverlaps( checkOverlaps ){}
+
+
+
+GeometryBuilder::~GeometryBuilder(){}
+
+
+
+G4VPhysicalVolume* GeometryBuilder::Build(){
+
+    vector<string> top = GetSubDirectories( "/volumes/" );
+    if( top.size()!=1 || GetName( top[0] )!="World" ){
+        Fatal( "volumes should contain exactly one top-level volume named World" );
+    }
+
+    FindVolumes( top[0] );
+
+    // Logical volumes are created first, so that volumes can be reused by name regardless of the order in the config.
+    //
+    for( auto itr = volumeDirs.begin(); itr!=volumeDirs.end(); itr++ ){
+        if( !fConfig->Find( itr->second+"logical" ) && !fConfig->Find( itr->second+"assembly" ) ){
+            logicalVolumes[ itr->first ] = BuildLogicalVolume( itr->second );
+        }
+    }
+
+    G4cout << GetClassName() << ": constructing World" << G4endl;
+
+    G4VPhysicalVolume* physWorld = new G4PVPlacement( 0, G4ThreeVector(0,0,0), logicalVolumes["World"], "World", 0, false, 0, fCheckOverlaps );
+
+    PlaceDaughters( top[0] );
+
+    return physWorld;
+}
+
+
+
+void GeometryBuilder::FindVolumes( const string& dir ){
+
+    string name = GetName( dir );
+    if( volumeDirs.find( name )!=volumeDirs.end() ){
+        Fatal( "volume " + name + " is defined in both " + volumeDirs[name] + " and " + dir );
+    }
+    volumeDirs[name] = dir;
+
+    vector<string> daughters = GetSubDirectories( dir );
+    for( auto itr = daughters.begin(); itr!=daughters.end(); itr++ ){
+        FindVolumes( *itr );
+    }
+}
+
+
+
+vector<string> GeometryBuilder::GetSubDirectories( const string& dir ){
+
+    vector<string> ret;
+
+    map< string, vector<string> > list = fConfig->GetListOfParameters( dir );
+    for( auto itr = list.begin(); itr!=list.end(); itr++ ){
+        if( *(itr->first.rbegin())=='/' ){
+            ret.push_back( itr->first );
+        }
+    }
+    return ret;
+}
+
+
+
+string GeometryBuilder::GetName( const string& dir ){
+    size_t pos = dir.rfind( '/', dir.size()-2 );
+    return dir.substr( pos+1, dir.size()-pos-2 );
+}
+
+
+
+G4VSolid* GeometryBuilder::GetSolid( const string& name ){
+
+    if( fConfig->Find( "/solids/"+name+"/" ) ){
+        return BuildSolid( name, "/solids/"+name+"/" );
+    }
+
+    auto itr = volumeDirs.find( name );
+    if( itr!=volumeDirs.end() ){
+        return BuildSolid( name, itr->second );
+    }
+
+    Fatal( "cannot find solid " + name );
+    return 0;
+}
+
+
+
+G4VSolid* GeometryBuilder::BuildSolid( const string& name, const string& dir ){
+
+    // Solids are cached by directory since a volume and an entry under solids may share a name.
+    //
+    auto cached = solids.find( dir );
+    if( cached!=solids.end() ){
+        return cached->second;
+    }
+
+    if( solidsInProgress.find( dir )!=solidsInProgress.end() ){
+        Fatal( "solid " + name + " refers to itself" );
+    }
+    solidsInProgress.insert( dir );
+
+    G4VSolid* solid = 0;
+    G4double unit = GetLengthUnit( dir );
+
+    string reference = fConfig->GetString( dir+"solid" );
+    string shape = fConfig->GetString( dir+"shape" );
+
+    if( reference!="" ){
+        solid = GetSolid( reference );
+    }
+
+    // box with full lengths in x, y and z
+    //
+    else if( shape=="box" ){
+        vector<double> size = fConfig->GetDoubleArray( dir+"size" );
+        if( size.size()!=3 ){
+            Fatal( "box " + name + " needs size : x y z" );
+        }
+        solid = new G4Box( name, size[0]*unit/2, size[1]*unit/2, size[2]*unit/2 );
+    }
+
+    // tube with inner and outer radii, full height and optionally the phi segment in degree
+    //
+    else if( shape=="tubs" ){
+        if( !fConfig->Find( dir+"rmax" ) || !fConfig->Find( dir+"height" ) ){
+            Fatal( "tubs " + name + " needs rmax and height" );
+        }
+        G4double rmax = fConfig->GetDouble( dir+"rmax", 0. ) * unit;
+        G4double height = fConfig->GetDouble( dir+"height", 0. ) * unit;
+        G4double rmin = fConfig->GetDouble( dir+"rmin", 0. ) * unit;
+        G4double startPhi = fConfig->GetDouble( dir+"startPhi", 0. ) * deg;
+        G4double deltaPhi = fConfig->GetDouble( dir+"deltaPhi", 360. ) * deg;
+
+        solid = new G4Tubs( name, rmin, rmax, height/2, startPhi, deltaPhi );
+    }
+
+    // boolean of two solids, the second of which is displaced by secondPosition and secondRotation
+    //
+    else if( shape=="union" || shape=="subtraction" || shape=="intersection" ){
+
+        string first = fConfig->GetString( dir+"first" );
+        string second = fConfig->GetString( dir+"second" );
+        if( first=="" || second=="" ){
+            Fatal( shape + " " + name + " needs first and second solids" );
+        }
+
+        G4VSolid* solidA = GetSolid( first );
+        G4VSolid* solidB = GetSolid( second );
+
+        vector<double> pos = fConfig->GetDoubleArray( dir+"secondPosition" );
+        pos.resize( 3, 0 );
+        G4ThreeVector translation = G4ThreeVector( pos[0], pos[1], pos[2] ) * unit;
+        G4RotationMatrix* rotation = GetRotation( fConfig->GetDoubleArray( dir+"secondRotation" ), 0 );
+
+        if( shape=="union" ){
+            solid = new G4UnionSolid( name, solidA, solidB, rotation, translation );
+        }
+        else if( shape=="subtraction" ){
+            solid = new G4SubtractionSolid( name, solidA, solidB, rotation, translation );
+        }
+        else{
+            solid = new G4IntersectionSolid( name, solidA, solidB, rotation, translation );
+        }
+    }
+
+    else{
+        Fatal( "unknown shape '" + shape + "' of " + name + ". Use box, tubs, union, subtraction or intersection" );
+    }
+
+    solidsInProgress.erase( dir );
+    solids[dir] = solid;
+
+    return solid;
+}
+
+
+
+G4LogicalVolume* GeometryBuilder::BuildLogicalVolume( const string& dir ){
+
+    string name = GetName( dir );
+
+    string materialName = fConfig->GetString( dir+"material" );
+    if( materialName=="" ){
+        Fatal( "volume " + name + " has no material" );
+    }
+
+    G4Material* material = GeometryManager::Get()->GetMaterial( materialName );
+    if( material==0 ){
+        Fatal( "cannot find material " + materialName + " of volume " + name );
+    }
+
+    G4LogicalVolume* lv = new G4LogicalVolume( BuildSolid( name, dir ), material, name );
+
+    // visual attributes
+    //
+    vector<double> colour = fConfig->GetDoubleArray( dir+"colour" );
+    bool visible = fConfig->GetBool( dir+"visible", true );
+
+    if( colour.size()>=3 || !visible ){
+        auto vis = new G4VisAttributes();
+        if( colour.size()>=3 ){
+            vis->SetColour( G4Colour( colour[0], colour[1], colour[2], colour.size()>3 ? colour[3] : 1 ) );
+        }
+        vis->SetVisibility( visible );
+        lv->SetVisAttributes( vis );
+    }
+
+    return lv;
+}
+
+
+
+void GeometryBuilder::PlaceDaughters( const string& dir ){
+
+    G4LogicalVolume* mother = logicalVolumes[ GetName( dir ) ];
+
+    vector<string> daughters = GetSubDirectories( dir );
+
+    for( auto itr = daughters.begin(); itr!=daughters.end(); itr++ ){
+
+        string name = GetName( *itr );
+
+        // A volume with logical : Name places the logical volume of Name (with its daughters) again,
+        // and one with assembly : Name the assembly registered in the code under Name (e.g. NaIDetector).
+        //
+        string reference = fConfig->GetString( *itr+"logical" );
+        string assembly = fConfig->GetString( *itr+"assembly" );
+        G4LogicalVolume* lv = 0;
+
+        if( assembly!="" ){
+            lv = AssemblyRegistry::Get()->GetLogicalVolume( assembly );
+            if( lv==0 ){
+                Fatal( "volume " + name + " refers to unknown assembly " + assembly );
+            }
+            reference = assembly;
+        }
+        else if( reference!="" ){
+            auto found = volumeDirs.find( reference );
+            if( found==volumeDirs.end() || logicalVolumes.find( reference )==logicalVolumes.end() ){
+                Fatal( "volume " + name + " refers to unknown volume " + reference );
+            }
+            if( itr->compare( 0, found->second.size(), found->second )==0 ){
+                Fatal( "volume " + name + " cannot be placed inside its own logical volume " + reference );
+            }
+            if( !GetSubDirectories( *itr ).empty() ){
+                G4cerr << GetClassName() << ": daughters of " << name << " are ignored since it reuses " << reference << G4endl;
+            }
+            lv = logicalVolumes[ reference ];
+        }
+        else{
+            lv = logicalVolumes[ name ];
+        }
+
+        // Position and rotation can list several copies; a single rotation applies to all of them.
+        //
+        G4double unit = GetLengthUnit( *itr );
+
+        vector<double> pos = fConfig->GetDoubleArray( *itr+"position" );
+        if( pos.empty() ){
+            pos.resize( 3, 0 );
+        }
+        vector<double> rot = fConfig->GetDoubleArray( *itr+"rotation" );
+
+        // Regular arrays of nx x ny x nz copies centred on position, see AssemblyRegistry::PlaceArray.
+        //
+        vector<int> array = fConfig->GetIntArray( *itr+"array" );
+        if( !array.empty() ){
+            vector<double> pitch = fConfig->GetDoubleArray( *itr+"pitch" );
+            string mode = fConfig->GetString( *itr+"arrayMode" );
+
+            if( array.size()!=3 || pitch.size()!=3 || pos.size()!=3 ){
+                Fatal( "array of " + name + " needs array : nx ny nz, pitch : x y z and a single position" );
+            }
+
+            AssemblyRegistry::Get()->PlaceArray( lv, name, mother, array[0], array[1], array[2],
+                                                 G4ThreeVector( pitch[0], pitch[1], pitch[2] ) * unit,
+                                                 G4ThreeVector( pos[0], pos[1], pos[2] ) * unit,
+                                                 GetRotation( rot, 0 ), mode=="" ? "placement" : mode, fCheckOverlaps );
+            if( reference=="" ){
+                PlaceDaughters( *itr );
+            }
+            continue;
+        }
+
+        if( pos.size()%3!=0 ){
+            Fatal( "position of " + name + " should be a multiple of 3 values" );
+        }
+        if( !rot.empty() && rot.size()!=3 && rot.size()!=pos.size() ){
+            Fatal( "rotation of " + name + " should be 3 values or 3 values per copy" );
+        }
+
+        for( size_t i = 0; i<pos.size()/3; i++ ){
+
+            G4ThreeVector translation = G4ThreeVector( pos[3*i], pos[3*i+1], pos[3*i+2] ) * unit;
+            G4RotationMatrix* rotation = GetRotation( rot, rot.size()==3 ? 0 : i );
+
+            new G4PVPlacement( rotation, translation, lv, name, mother, false, i, fCheckOverlaps );
+
+            G4cout << GetClassName() << ": constructing " << name << " (" << i << ") in " << mother->GetName()
+                << " at " << translation/cm << " cm\n";
+        }
+
+        if( reference=="" ){
+            PlaceDaughters( *itr );
+        }
+    }
+}
+
+
+
+G4double GeometryBuilder::GetLengthUnit( const string& dir ){
+
+    string unit = fConfig->GetString( dir+"unit" );
+
+    if( unit=="" || unit=="cm" ){
+        return cm;
+    }
+    if( unit=="mm" ){
+        return mm;
+    }
+    if( unit=="m" ){
+        return m;
+    }
+    Fatal( "unknown unit '" + unit + "' in " + dir + ". Use mm, cm or m" );
+    return cm;
+}
+
+
+
+G4RotationMatrix* GeometryBuilder::GetRotation( const vector<double>& angles, size_t index ){
+
+    if( angles.size()<3*index+3 ){
+        return 0;
+    }
+    if( angles[3*index]==0 && angles[3*index+1]==0 && angles[3*index+2]==0 ){
+        return 0;
+    }
+
+    auto rotation = new G4RotationMatrix();
+    rotation->rotateX( angles[3*index] * deg );
+    rotation->rotateY( angles[3*index+1] * deg );
+    rotation->rotateZ( angles[3*index+2] * deg );
+
+    return rotation;
+}
+
+
+
+void GeometryBuilder::Fatal( const string& message ){
+    G4Exception( "GeometryBuilder::Build", "Geometry001", FatalException, message.c_str() );
+}
@@ -8,12 +8,29 @@
 
 #include "GeometryConstruction.hh"
 #include "GeometryConstructionMessenger.hh"
+#include "PhysicsTableCache.hh"
+#include "GeometryBuilder.hh"
+#include "AssemblyRegistry.hh"
+#include "LightCollectionMap.hh"
 
 #include "G4Box.hh"
 #include "G4Tubs.hh"
 #include "G4SubtractionSolid.hh"
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4SolidStore.hh"
+#include "G4Material.hh"
+#include "G4RegionStore.hh"
+#include "G4Region.hh"
+#include "G4ProductionCuts.hh"
+#include "G4UserLimits.hh"
+#include "G4RunManager.hh"
+#include "G4VUserPhysicsList.hh"
+#include "G4EmParameters.hh"
+
+#include "G4BOptrForceCollision.hh"
 
 #include "G4VisAttributes.hh"
 #include "G4Colour.hh"
@@ -24,6 +41,13 @@
 #include "G4SystemOfUnits.hh"
 
 #include <sstream>
+#include <fstream>
+#include <cfloat>
+#include <cstdio>
+#include <filesystem>
+#include <algorithm>
+#include <map>
+#include <unistd.h>
 
 
 
@@ -33,11 +57,16 @@ GeometryConstruction::GeometryConstruction( GeometryManager* gm) : G4VUserDetect
     fDetectorMessenger = new GeometryConstructionMessenger(this);
 
     detector_assembly = NaIDetector();
+
+    // Assemblies are built once per construction and shared by all their placements.
+    //
+    AssemblyRegistry::Get()->Register( "NaIDetector", [this](){ return detector_assembly.GetLogicalVolume(); } );
 }
 
 
 
 GeometryConstruction::~GeometryConstruction(){
+    AssemblyRegistry::Get()->Unregister( "NaIDetector" );
     delete fDetectorMessenger;
 }
 
@@ -47,12 +76,21 @@ G4VPhysicalVolume* GeometryConstruction::Construct(){
     
     G4cout << GetClassName() << ": Constructing geometry...\n";
 
+    GeometryManager::Get()->InvalidateIndex();
+    AssemblyRegistry::Get()->Clear();
+
     // Obtain the name of geometry from configuration parser
     // This geometry name will be converted into a code and used in a switch statement
     //
     G4String GeometryName = GeometryManager::Get()->GetConfigParser()->GetString( "type", "crystal" );
     G4cout << GetClassName() << ": name of geometry is " << GeometryName << G4endl;
 
+    // Overlaps are checked at each placement (construct), once after construction (deferred) or not at all (off).
+    //
+    G4String overlapMode = GeometryManager::Get()->GetConfigParser()->GetString( "/overlaps/mode", "construct" );
+    fCheckOverlaps = overlapMode=="construct";
+    detector_assembly.SetCheckOverlaps( fCheckOverlaps );
+
     // Declare physical world
     // The definicition of world should be done by each user-case function in the 
     //
@@ -70,6 +108,19 @@ G4VPhysicalVolume* GeometryConstruction::Construct(){
             physWorld = ConstructCrystal();
             break;
 
+        // volumes described in the config, see the geometry directory for examples
+        case 2:
+            {
+                GeometryBuilder builder( const_cast<ConfigParser*>( GeometryManager::Get()->GetConfigParser() ), fCheckOverlaps );
+                physWorld = builder.Build();
+            }
+            break;
+
+        // world exported to GDML, e.g. by an earlier job
+        case 3:
+            physWorld = ConstructFromGDML();
+            break;
+
         // a simple lead castle and a NaI crystal inside
         case 100:
             physWorld = ConstructKamiokaGamma2023();
@@ -97,19 +148,481 @@ G4VPhysicalVolume* GeometryConstruction::Construct(){
     }
 
     // set the visual aspects of logic world
-    // !!! This assumes that user has created World volume named World in the ConstrctXXX code !!!
+    // The world read from GDML may have a different name, so the returned world is used instead of looking up World.
     //
-    G4LogicalVolume* logicWorld = GeometryManager::Get()->GetLogicalVolume("World");
+    G4LogicalVolume* logicWorld = physWorld->GetLogicalVolume();
 
     auto visWorld = new G4VisAttributes();
     visWorld->SetForceWireframe(true);
     visWorld->SetVisibility(true);
     logicWorld->SetVisAttributes(visWorld);
+
+    ConstructRegions();
+
+    ConfigureNavigation();
+
+    // Optical properties for the light collection map (--opticalMap). Ignored without optical physics.
+    //
+    if( GeometryManager::Get()->GetConfigParser()->Find( "/optical/" ) ){
+        LightCollectionMap::AddOpticalProperties();
+    }
+
+    if( overlapMode=="deferred" ){
+        CheckOverlaps();
+    }
+
+    ExportGDML( physWorld );
+
+    // Materials and cuts are final here, before the physics tables are built.
+    //
+    PhysicsTableCache::Get()->Prepare();
     
     return physWorld;
 }
 
 
+G4VPhysicalVolume* GeometryConstruction::ConstructFromGDML(){
+
+    G4String fileName = GeometryManager::Get()->GetConfigParser()->GetString( "/gdml/file" );
+
+#ifdef WITH_GDML
+    if( fileName=="" ){
+        G4Exception( "GeometryConstruction::ConstructFromGDML", "Geometry002", FatalException, "type GDML needs the file name in gdml/file." );
+    }
+
+    G4cout << GetClassName() << ": reading geometry from " << fileName << G4endl;
+
+    // Clear allows the file to be read again when the geometry is rebuilt between runs.
+    // Schema validation is skipped since the file is normally written by the same program.
+    //
+    fGDMLParser.Clear();
+    fGDMLParser.Read( fileName, false );
+
+    return fGDMLParser.GetWorldVolume();
+#else
+    G4Exception( "GeometryConstruction::ConstructFromGDML", "Geometry002", FatalException,
+        ( "cannot read " + fileName + ": RadetSim was built without GDML support (cmake -DWITH_GDML=ON)." ).c_str() );
+    return 0;
+#endif
+}
+
+
+
+/// Appends _0, _1, ... to the names shared by several objects of a store and records the old names.
+//
+template<class T> static void MakeNamesUnique( const std::vector<T*>& store, std::vector< std::pair<T*, G4String> >& renamed ){
+
+    std::map<G4String, int> count;
+    for( size_t i=0; i<store.size(); i++ ){
+        count[ store[i]->GetName() ]++;
+    }
+
+    std::map<G4String, int> index;
+    for( size_t i=0; i<store.size(); i++ ){
+        G4String name = store[i]->GetName();
+        if( count[name]>1 ){
+            renamed.push_back( std::make_pair( store[i], name ) );
+            store[i]->SetName( name + "_" + std::to_string( index[name]++ ) );
+        }
+    }
+}
+
+
+
+void GeometryConstruction::ExportGDML( G4VPhysicalVolume* world ){
+
+    GeometryManager::Get()->SetGDMLFile( "" );
+
+    G4String fileName = GeometryManager::Get()->GetConfigParser()->GetString( "/gdml/export" );
+    if( fileName=="" ){
+        return;
+    }
+
+#ifdef WITH_GDML
+    // The writer does not overwrite existing files, and the geometry may be exported again after /geometry/set.
+    //
+    std::remove( fileName.c_str() );
+
+    // Names are written without the 0x... address suffix so that they match the tree and geometryTable.
+    // Logical volumes, solids and materials are referenced by name in GDML, so duplicated names get a
+    // counter while the file is written. Physical volumes are not referenced and keep their names.
+    //
+    std::vector< std::pair<G4LogicalVolume*, G4String> > volumes;
+    std::vector< std::pair<G4VSolid*, G4String> > solids;
+    std::vector< std::pair<G4Material*, G4String> > materials;
+
+    MakeNamesUnique<G4LogicalVolume>( *G4LogicalVolumeStore::GetInstance(), volumes );
+    MakeNamesUnique<G4VSolid>( *G4SolidStore::GetInstance(), solids );
+    MakeNamesUnique<G4Material>( *G4Material::GetMaterialTable(), materials );
+
+    fGDMLParser.Write( fileName, world, false );
+
+    for( auto itr = volumes.begin(); itr!=volumes.end(); itr++ ){
+        itr->first->SetName( itr->second );
+    }
+    for( auto itr = solids.begin(); itr!=solids.end(); itr++ ){
+        itr->first->SetName( itr->second );
+    }
+    for( auto itr = materials.begin(); itr!=materials.end(); itr++ ){
+        itr->first->SetName( itr->second );
+    }
+
+    GeometryManager::Get()->SetGDMLFile( fileName );
+#else
+    G4cerr << GetClassName() << ": gdml/export is ignored since RadetSim was built without GDML support." << G4endl;
+#endif
+}
+
+
+
+void GeometryConstruction::CheckOverlaps(){
+
+    const ConfigParser* config = GeometryManager::Get()->GetConfigParser();
+
+    G4int resolution = config->GetInt( "/overlaps/resolution", 1000 );
+    G4double tolerance = config->GetDouble( "/overlaps/tolerance", 0. ) * mm;
+
+    // Cache file holds pass or fail, the resolution and the names of overlapping volumes.
+    //
+    G4String cacheDir = GeometryManager::Get()->GetCacheDirectory();
+    std::string cacheFile = "";
+    if( cacheDir!="" ){
+        cacheFile = cacheDir + "/" + GeometryManager::Get()->GetGeometryHash() + ".overlaps";
+
+        std::ifstream file( cacheFile );
+        std::string result;
+        G4int cachedResolution = 0;
+        if( file >> result >> cachedResolution && cachedResolution>=resolution ){
+            std::string name;
+            while( file >> name ){
+                G4cerr << GetClassName() << ": " << name << " overlaps (cached result)." << G4endl;
+            }
+            G4cout << GetClassName() << ": overlap check " << result << " with resolution " << cachedResolution << " (cached)." << G4endl;
+            return;
+        }
+    }
+
+    // Replicas and parameterised volumes are not checked by G4VPhysicalVolume::CheckOverlaps.
+    //
+    std::vector<G4VPhysicalVolume*> placements;
+    std::vector<G4String> skipped;
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    for( auto itr = store->begin(); itr!=store->end(); itr++ ){
+        if( (*itr)->GetMotherLogical()==0 ){
+            continue;
+        }
+        if( (*itr)->IsReplicated() ){
+            skipped.push_back( (*itr)->GetName() );
+            continue;
+        }
+        placements.push_back( *itr );
+    }
+
+    for( size_t i=0; i<skipped.size(); i++ ){
+        G4cout << GetClassName() << ": " << skipped[i] << " is a replica or parameterised volume and is not checked for overlaps." << G4endl;
+    }
+
+    // The check runs in the master thread. Solids and materials of logical volumes are thread-local in
+    // multi-threaded builds and solids fill their caches lazily, so the placements are not checked in parallel.
+    //
+    G4cout << GetClassName() << ": checking " << placements.size() << " placements for overlaps..." << G4endl;
+
+    std::vector<char> overlaps( placements.size(), 0 );
+    for( size_t i=0; i<placements.size(); i++ ){
+        overlaps[i] = placements[i]->CheckOverlaps( resolution, tolerance, true, 1 );
+    }
+
+    std::vector<G4String> failed;
+    for( size_t i=0; i<placements.size(); i++ ){
+        if( overlaps[i] ){
+            failed.push_back( placements[i]->GetName() );
+            G4cerr << GetClassName() << ": " << placements[i]->GetName() << " overlaps." << G4endl;
+        }
+    }
+
+    G4String result = failed.empty() ? "pass" : "fail";
+    G4cout << GetClassName() << ": overlap check " << result << " with resolution " << resolution << G4endl;
+
+    if( cacheFile!="" ){
+
+        std::error_code error;
+        std::filesystem::create_directories( cacheDir.c_str(), error );
+
+        std::ostringstream tmp;
+        tmp << cacheFile << ".tmp" << getpid();
+
+        std::ofstream file( tmp.str() );
+        file << result << ' ' << resolution << '\n';
+        for( size_t i=0; i<failed.size(); i++ ){
+            file << failed[i] << '\n';
+        }
+        file.close();
+
+        std::rename( tmp.str().c_str(), cacheFile.c_str() );
+    }
+}
+
+
+void GeometryConstruction::ConfigureNavigation(){
+
+    // navigation/smartless applies to all volumes, and directories under navigation to single volumes.
+    // smartless is the average number of voxels per daughter (Geant4 default 2); more voxels speed up
+    // navigation in mothers with many daughters at the cost of memory. optimise : false disables voxels.
+    //
+    ConfigParser* config = const_cast<ConfigParser*>( GeometryManager::Get()->GetConfigParser() );
+
+    bool found = false;
+    G4double smartless = config->GetDouble( "/navigation/smartless", &found );
+    if( found ){
+        G4cout << GetClassName() << ": smartless of all volumes is " << smartless << G4endl;
+        auto store = G4LogicalVolumeStore::GetInstance();
+        for( auto itr = store->begin(); itr!=store->end(); itr++ ){
+            (*itr)->SetSmartless( smartless );
+        }
+    }
+
+    map< string, vector<string> > volumes = config->GetListOfParameters( "/navigation/" );
+
+    for( auto itr = volumes.begin(); itr!=volumes.end(); itr++ ){
+
+        string dir = itr->first;
+        if( *dir.rbegin()!='/' ){
+            continue;
+        }
+        string name = dir.substr( 12, dir.size()-13 );
+
+        G4LogicalVolume* lv = FindLogicalVolume( name );
+        if( lv==0 ){
+            G4cerr << GetClassName() << ": cannot find volume " << name << " under navigation. Skipping..." << G4endl;
+            continue;
+        }
+
+        smartless = config->GetDouble( dir+"smartless", &found );
+        if( found ){
+            lv->SetSmartless( smartless );
+        }
+        lv->SetOptimisation( config->GetBool( dir+"optimise", true ) );
+
+        G4cout << GetClassName() << ": " << name << " smartless " << lv->GetSmartless()
+            << ( lv->IsToOptimise() ? "" : ", not optimised" ) << G4endl;
+    }
+}
+
+
+
+void GeometryConstruction::ConstructRegions(){
+
+    // Each region is a directory under regions, e.g.
+    //  regions {
+    //      Rock { volumes : Rock Floor, cut : 10, minEkin : 100, }
+    //  }
+    // Cuts, ranges and step lengths are in mm, energies in keV.
+    //
+    ConfigParser* config = const_cast<ConfigParser*>( GeometryManager::Get()->GetConfigParser() );
+
+    map< string, vector<string> > regions = config->GetListOfParameters( "/regions/" );
+
+    // User limits are applied to the daughters once all region roots are known,
+    // so that the limits of a region do not depend on the order in which nested regions are defined.
+    //
+    vector< std::pair< vector<G4LogicalVolume*>, G4UserLimits* > > pendingLimits;
+
+    for( auto itr = regions.begin(); itr!=regions.end(); itr++ ){
+
+        string dir = itr->first;
+        if( *dir.rbegin()!='/' ){
+            continue;
+        }
+        string name = dir.substr( 9, dir.size()-10 );
+
+        vector<string> volumes = config->GetStrArray( dir+"volumes" );
+        if( volumes.empty() ){
+            G4cerr << GetClassName() << ": region " << name << " has no volumes. Skipping..." << G4endl;
+            continue;
+        }
+
+        G4Region* region = G4RegionStore::GetInstance()->FindOrCreateRegion( name );
+
+        vector<G4LogicalVolume*> roots;
+        for( auto vitr = volumes.begin(); vitr!=volumes.end(); vitr++ ){
+            G4LogicalVolume* lv = FindLogicalVolume( *vitr );
+            if( lv==0 ){
+                G4cerr << GetClassName() << ": cannot find volume " << *vitr << " for region " << name << ". Skipping..." << G4endl;
+                continue;
+            }
+            region->AddRootLogicalVolume( lv );
+            roots.push_back( lv );
+        }
+
+        // Production cuts. cut sets gamma, e- and e+ at once, and can be overridden per particle.
+        //
+        G4double cut = config->GetDouble( dir+"cut", -1 );
+        G4double gammaCut = config->GetDouble( dir+"gammaCut", cut );
+        G4double electronCut = config->GetDouble( dir+"electronCut", cut );
+        G4double positronCut = config->GetDouble( dir+"positronCut", cut );
+        G4double protonCut = config->GetDouble( dir+"protonCut", -1 );
+
+        if( gammaCut>0 || electronCut>0 || positronCut>0 || protonCut>0 ){
+
+            G4ProductionCuts* cuts = region->GetProductionCuts();
+            if( cuts==0 ){
+                cuts = new G4ProductionCuts();
+                region->SetProductionCuts( cuts );
+            }
+
+            // Particles without an explicit cut get the default cut of the physics list.
+            //
+            const G4VUserPhysicsList* physicsList = G4RunManager::GetRunManager()->GetUserPhysicsList();
+            cuts->SetProductionCut( physicsList!=0 ? physicsList->GetDefaultCutValue() : 0.7*mm );
+
+            if( gammaCut>0 )    cuts->SetProductionCut( gammaCut*mm, "gamma" );
+            if( electronCut>0 ) cuts->SetProductionCut( electronCut*mm, "e-" );
+            if( positronCut>0 ) cuts->SetProductionCut( positronCut*mm, "e+" );
+            if( protonCut>0 )   cuts->SetProductionCut( protonCut*mm, "proton" );
+        }
+
+        // User limits take effect through G4StepLimiterPhysics registered in main.
+        //
+        G4double maxStep = config->GetDouble( dir+"maxStep", -1 );
+        G4double minEkin = config->GetDouble( dir+"minEkin", -1 );
+        G4double minRange = config->GetDouble( dir+"minRange", -1 );
+
+        if( maxStep>0 || minEkin>0 || minRange>0 ){
+
+            G4UserLimits* limits = new G4UserLimits(
+                maxStep>0 ? maxStep*mm : DBL_MAX,
+                DBL_MAX,
+                DBL_MAX,
+                minEkin>0 ? minEkin*keV : 0.,
+                minRange>0 ? minRange*mm : 0.
+            );
+            region->SetUserLimits( limits );
+
+            pendingLimits.push_back( std::make_pair( roots, limits ) );
+        }
+
+        // EM option of the region. Applied by the EM constructor of the physics list, which is built after the geometry.
+        //
+        G4String em = GetEmPhysicsName( config->GetString( dir+"em" ) );
+        if( em!="" ){
+            G4EmParameters::Instance()->AddPhysics( name, em );
+        }
+
+        G4cout << GetClassName() << ": region " << name << " with " << roots.size() << " root volume(s)";
+        if( em!="" )        G4cout << ", " << em;
+        if( gammaCut>0 )    G4cout << ", gamma cut " << gammaCut << " mm";
+        if( electronCut>0 ) G4cout << ", e- cut " << electronCut << " mm";
+        if( positronCut>0 ) G4cout << ", e+ cut " << positronCut << " mm";
+        if( protonCut>0 )   G4cout << ", proton cut " << protonCut << " mm";
+        if( maxStep>0 )     G4cout << ", max step " << maxStep << " mm";
+        if( minEkin>0 )     G4cout << ", min Ekin " << minEkin << " keV";
+        if( minRange>0 )    G4cout << ", min range " << minRange << " mm";
+        G4cout << G4endl;
+    }
+
+    for( auto itr = pendingLimits.begin(); itr!=pendingLimits.end(); itr++ ){
+        for( auto ritr = itr->first.begin(); ritr!=itr->first.end(); ritr++ ){
+            (*ritr)->SetUserLimits( itr->second );
+            SetUserLimits( *ritr, itr->second );
+        }
+    }
+}
+
+
+G4String GeometryConstruction::GetEmPhysicsName( G4String input ){
+
+    if( input=="" ){
+        return "";
+    }
+
+    if( input=="opt0" ) return "G4EmStandard";
+    if( input=="opt1" ) return "G4EmStandard_opt1";
+    if( input=="opt2" ) return "G4EmStandard_opt2";
+    if( input=="opt3" ) return "G4EmStandard_opt3";
+    if( input=="opt4" ) return "G4EmStandard_opt4";
+    if( input=="livermore" ) return "G4EmLivermore";
+    if( input=="penelope" ) return "G4EmPenelope";
+
+    const char* known[] = { "G4EmStandard", "G4EmStandard_opt1", "G4EmStandard_opt2", "G4EmStandard_opt3", "G4EmStandard_opt4",
+                            "G4EmLivermore", "G4EmPenelope", "G4EmLowEP", "G4EmStandardGS", "G4EmStandardSS", "G4EmStandardWVI" };
+    for( auto name : known ){
+        if( input==name ){
+            return input;
+        }
+    }
+
+    G4cerr << GetClassName() << ": unknown EM option " << input << ". Using the default of the physics list..." << G4endl;
+    return "";
+}
+
+
+void GeometryConstruction::SetUserLimits( G4LogicalVolume* lv, G4UserLimits* limits ){
+
+    for( size_t i=0; i<lv->GetNoDaughters(); i++ ){
+
+        // Daughters that are roots of another region keep the limits of their own region.
+        //
+        G4LogicalVolume* daughter = lv->GetDaughter(i)->GetLogicalVolume();
+        if( daughter->IsRootRegion() ){
+            continue;
+        }
+
+        if( daughter->GetUserLimits()==0 ){
+            daughter->SetUserLimits( limits );
+        }
+        SetUserLimits( daughter, limits );
+    }
+}
+
+
+G4LogicalVolume* GeometryConstruction::FindLogicalVolume( G4String name ){
+
+    G4VPhysicalVolume* pv = G4PhysicalVolumeStore::GetInstance()->GetVolume( name, false );
+    if( pv!=0 ){
+        return pv->GetLogicalVolume();
+    }
+    return G4LogicalVolumeStore::GetInstance()->GetVolume( name, false );
+}
+
+
+// One operator per thread. ConstructSDandField is called again when the geometry is rebuilt,
+// and the same operator is then attached to the new volumes.
+//
+static G4ThreadLocal G4BOptrForceCollision* forceCollisionOperator = 0;
+
+
+void GeometryConstruction::ConstructSDandField(){
+
+    // Volumes in which gammas are forced to interact.
+    // Names can be either physical or logical volume names.
+    // The operator has effect only if generic biasing physics is registered (--bias option).
+    //
+    vector<string> forceCollision = GeometryManager::Get()->GetConfigParser()->GetStrArray( "/biasing/forceCollision" );
+
+    if( forceCollision.empty() ){
+        return;
+    }
+
+    if( forceCollisionOperator==0 ){
+        forceCollisionOperator = new G4BOptrForceCollision( "gamma", "ForceCollision" );
+    }
+
+    for( auto itr = forceCollision.begin(); itr!=forceCollision.end(); itr++ ){
+
+        G4LogicalVolume* lv = FindLogicalVolume( *itr );
+
+        if( lv==0 ){
+            G4cerr << GetClassName() << ": cannot find volume " << *itr << " for forced collision. Skipping..." << G4endl;
+            continue;
+        }
+
+        G4cout << GetClassName() << ": forcing gamma collision in " << lv->GetName() << G4endl;
+        forceCollisionOperator->AttachTo( lv );
+    }
+}
+
+
+
 int GeometryConstruction::GetGeometryCode( G4String input ){
 
     if( input == "Rock" ){
@@ -118,6 +631,12 @@ int GeometryConstruction::GetGeometryCode( G4String input ){
     if( input == "Crystal" ){
         return 1;
     }
+    if( input == "Config" ){
+        return 2;
+    }
+    if( input == "GDML" ){
+        return 3;
+    }
     if( input == "KamiokaGamma-2023" ){
         return 100;
     }
@@ -393,7 +912,7 @@ G4VPhysicalVolume* GeometryConstruction::ConstructKamiokaGamma2025( int option )
 
     logicShielding->SetVisAttributes(G4VisAttributes(G4Colour(0.2, 0.2, 0.2, 0.5)));
     
-    auto logicNaIDetector = detector_assembly.GetLogicalVolume();
+    auto logicNaIDetector = AssemblyRegistry::Get()->GetLogicalVolume( "NaIDetector" );
 
     // Internal background measurements
     // Configuration is lead shielding + inner space + NaI detector assembly
@@ -427,7 +946,7 @@ G4VPhysicalVolume* GeometryConstruction::ConstructKamiokaGamma2025( int option )
         rotation->rotateX(180.0 * deg);
             // in the internal background measurement, the detector is oriented upward, so apply rotation
 
-        auto physNaIDetector = new G4PVPlacement( rotation, G4ThreeVector(0,0,posZ), logicNaIDetector, name, logicShieldingInside, false, 0);
+        auto physNaIDetector = AssemblyRegistry::Get()->Place( name, logicShieldingInside, G4ThreeVector(0,0,posZ), rotation, false );
     }
 
     // Bottom measurements
@@ -455,7 +974,7 @@ G4VPhysicalVolume* GeometryConstruction::ConstructKamiokaGamma2025( int option )
         //
         name = logicNaIDetector->GetName();
         G4double detPosZ = -innerShieldingZ/2 + detector_assembly.GetLength()/2;
-        auto physNaIDetector = new G4PVPlacement( 0, G4ThreeVector(0,0,detPosZ), logicNaIDetector, name, logicShieldingInside, false, 0);
+        auto physNaIDetector = AssemblyRegistry::Get()->Place( name, logicShieldingInside, G4ThreeVector(0,0,detPosZ), 0, false );
 
         // Rock on the floor
         //
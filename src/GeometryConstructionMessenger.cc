@@ -18,6 +18,11 @@
 #include "G4UIcmdWithoutParameter.hh"
 
 #include "GeometryManager.hh"
+#include "LineOfSight.hh"
+#include "RunAction.hh"
+
+#include "G4RunManager.hh"
+#include "G4StateManager.hh"
 
 
 GeometryConstructionMessenger::GeometryConstructionMessenger( GeometryConstruction* placement) : G4UImessenger(){
@@ -42,7 +47,32 @@ GeometryConstructionMessenger::GeometryConstructionMessenger( GeometryConstructi
     //
    	fConfigCmd = new G4UIcmdWithAString( "/geometry/loadconfig", this );
 	fConfigCmd->SetGuidance( "Load the specified configuration file, which includes necessary parameters as name-value pairs." );
- 
+
+    // compute masses once with higher precision and store them in the geometry cache.
+    //
+    fPrecomputeMassCmd = new G4UIcmdWithAnInteger( "/geometry/precomputeMass", this );
+    fPrecomputeMassCmd->SetGuidance( "Compute the mass of all volumes, estimating boolean solids with the given number of points." );
+    fPrecomputeMassCmd->SetGuidance( "Results are stored in the directory given by --geometryCache and reused by later jobs." );
+    fPrecomputeMassCmd->SetParameterName( "nStat", true );
+    fPrecomputeMassCmd->SetDefaultValue( 10000000 );
+    fPrecomputeMassCmd->AvailableForStates( G4State_Idle );
+
+    // change a config parameter; after initialization the geometry is rebuilt at the next run.
+    //
+    fSetCmd = new G4UIcmdWithAString( "/geometry/set", this );
+    fSetCmd->SetGuidance( "Set a parameter of the geometry config, e.g. /geometry/set /crystal/diameter 5" );
+    fSetCmd->SetGuidance( "After /run/initialize, the geometry is reconstructed before the next run." );
+    fSetCmd->SetParameterName( "parameter", false );
+    fSetCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    // uncollided flux from a source material in the detector, configured under attenuation in the config.
+    //
+    fLineOfSightCmd = new G4UIcmdWithAnInteger( "/geometry/lineOfSight", this );
+    fLineOfSightCmd->SetGuidance( "Estimate the uncollided gamma flux in attenuation/detector from attenuation/source by ray tracing." );
+    fLineOfSightCmd->SetGuidance( "The argument is the number of rays; 0 uses attenuation/rays of the config." );
+    fLineOfSightCmd->SetParameterName( "rays", true );
+    fLineOfSightCmd->SetDefaultValue( 0 );
+    fLineOfSightCmd->AvailableForStates( G4State_Idle );
 }
 
 
@@ -59,4 +89,33 @@ void GeometryConstructionMessenger::SetNewValue( G4UIcommand* command, G4String
 	    G4cout << GetClassName() <<": loading configuration file " << newValue << G4endl;
 		GeometryManager::Get()->LoadFile( newValue );
 	}
+	else if( command == fSetCmd ){
+        std::istringstream ss( newValue );
+        std::string name, value;
+        ss >> name;
+        std::getline( ss >> std::ws, value );
+        if( name=="" || value=="" ){
+            G4cerr << GetClassName() << ": usage is /geometry/set parameter value(s)" << G4endl;
+            return;
+        }
+	    G4cout << GetClassName() << ": setting " << name << " to " << value << G4endl;
+		GeometryManager::Get()->SetParameter( name, value );
+        if( G4StateManager::GetStateManager()->GetCurrentState()==G4State_Idle ){
+            G4RunManager::GetRunManager()->ReinitializeGeometry( true );
+        }
+	}
+	else if( command == fPrecomputeMassCmd ){
+		GeometryManager::Get()->PrecomputeMass( fPrecomputeMassCmd->ConvertToInt(newValue) );
+	}
+	else if( command == fLineOfSightCmd ){
+        LineOfSight estimator;
+        estimator.Run( fLineOfSightCmd->ConvertToInt(newValue) );
+
+        // the result is written to the output next to the run metadata
+        //
+        const RunAction* runAction = dynamic_cast<const RunAction*>( G4RunManager::GetRunManager()->GetUserRunAction() );
+        if( runAction!=0 && !estimator.GetSummary().empty() ){
+            const_cast<RunAction*>( runAction )->SetMetadata( "lineOfSight", estimator.GetSummary() );
+        }
+	}
 }
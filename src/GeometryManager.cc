@@ -6,8 +6,26 @@
 
 #include "GeometryManager.hh"
 #include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4BooleanSolid.hh"
+#include "G4MultiUnion.hh"
+#include "G4Material.hh"
+#include "G4VPVParameterisation.hh"
+#include "G4ReplicaNavigation.hh"
 #include "G4RunManager.hh"
 
+#include "utility.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <filesystem>
+#include <unistd.h>
+
 
 GeometryManager* GeometryManager::manager = 0;
 
@@ -29,6 +47,13 @@ GeometryManager::GeometryManager(){
     fGeometryType = 1;
         // Default geometry is type = 0
 
+    indexBuilt = false;
+    indexedVolumes = 0;
+    geometryVersion = 0;
+
+    massCacheLoaded = false;
+    massCacheModified = false;
+
     material_manager = GetMaterialManager();
     DefineMaterials();
 }
@@ -40,60 +65,368 @@ GeometryManager::~GeometryManager(){
 
 
 G4LogicalVolume* GeometryManager::GetLogicalVolume( G4String name ){
-    return G4PhysicalVolumeStore::GetInstance()->GetVolume( name )->GetLogicalVolume();
+    G4VPhysicalVolume* pv = GetPhysicalVolume( name );
+    if( pv!=0 ){
+        return pv->GetLogicalVolume();
+    }
+    return G4LogicalVolumeStore::GetInstance()->GetVolume( name, false );
 }
 
 
 G4VPhysicalVolume* GeometryManager::GetPhysicalVolume( G4String name ){
-    return G4PhysicalVolumeStore::GetInstance()->GetVolume( name );
+    std::vector<G4VPhysicalVolume*> volumes = GetPhysicalVolumes( name );
+    return volumes.empty() ? 0 : volumes[0];
+}
+
+
+std::vector<G4VPhysicalVolume*> GeometryManager::GetPhysicalVolumes( G4String name ){
+
+    GeometryManager* gm = Get();
+    gm->CheckIndex();
+
+    auto itr = gm->volumeIndex.find( name );
+    if( itr==gm->volumeIndex.end() ){
+        return std::vector<G4VPhysicalVolume*>();
+    }
+    return itr->second;
+}
+
+
+G4ThreeVector GeometryManager::GetGlobalPosition( G4VPhysicalVolume* pv, size_t instance ){
+    return GetGlobalTransform( pv, instance ).NetTranslation();
+}
+
+
+G4AffineTransform GeometryManager::GetGlobalTransform( G4VPhysicalVolume* pv, size_t instance ){
+
+    GeometryManager* gm = Get();
+    gm->CheckIndex();
+
+    auto itr = gm->transformIndex.find( pv );
+    if( itr==gm->transformIndex.end() || itr->second.empty() ){
+        // Not connected to a world volume.
+        return G4AffineTransform( pv->GetRotation(), pv->GetTranslation() );
+    }
+
+    if( instance>=itr->second.size() ){
+        instance = 0;
+    }
+    return itr->second[instance];
+}
+
+
+size_t GeometryManager::GetNumberOfInstances( G4VPhysicalVolume* pv ){
+
+    GeometryManager* gm = Get();
+    gm->CheckIndex();
+
+    auto itr = gm->transformIndex.find( pv );
+    return itr==gm->transformIndex.end() ? 0 : itr->second.size();
+}
+
+
+G4VisExtent GeometryManager::GetGlobalExtent( G4VPhysicalVolume* pv, size_t instance ){
+
+    G4AffineTransform transform = GetGlobalTransform( pv, instance );
+    G4VisExtent extent = pv->GetLogicalVolume()->GetSolid()->GetExtent();
+
+    G4ThreeVector min( DBL_MAX, DBL_MAX, DBL_MAX );
+    G4ThreeVector max( -DBL_MAX, -DBL_MAX, -DBL_MAX );
+
+    for( G4int i=0; i<8; i++ ){
+        G4ThreeVector corner( i&1 ? extent.GetXmax() : extent.GetXmin(), i&2 ? extent.GetYmax() : extent.GetYmin(), i&4 ? extent.GetZmax() : extent.GetZmin() );
+        corner = transform.TransformPoint( corner );
+        for( G4int j=0; j<3; j++ ){
+            min[j] = std::min( min[j], corner[j] );
+            max[j] = std::max( max[j], corner[j] );
+        }
+    }
+
+    return G4VisExtent( min.x(), max.x(), min.y(), max.y(), min.z(), max.z() );
+}
+
+
+void GeometryManager::InvalidateIndex(){
+
+    // Masses computed for the old geometry are kept on disk before the cache is cleared.
+    //
+    SaveMassCache();
+
+    indexBuilt = false;
+    geometryVersion++;
+    geometryHash = "";
+    massCache.clear();
+    massCacheLoaded = false;
+}
+
+
+std::string GeometryManager::GetGeometryHash(){
+
+    CheckIndex();
+
+    if( geometryHash!="" ){
+        return geometryHash;
+    }
+
+    std::ostringstream ss;
+    ss.precision( 12 );
+
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    for( auto itr = store->begin(); itr!=store->end(); itr++ ){
+
+        G4VPhysicalVolume* pv = *itr;
+        G4LogicalVolume* lv = pv->GetLogicalVolume();
+
+        ss << "pv " << pv->GetName() << ' ' << pv->GetCopyNo() << ' ' << pv->GetMultiplicity() << ' '
+           << ( pv->GetMotherLogical()!=0 ? pv->GetMotherLogical()->GetName() : G4String("-") ) << ' '
+           << pv->GetObjectTranslation() << ' ' << pv->GetObjectRotationValue() << '\n';
+
+        ss << "lv " << lv->GetName() << ' ' << lv->GetMaterial()->GetName() << ' ' << lv->GetMaterial()->GetDensity()/(g/cm3) << '\n';
+
+        lv->GetSolid()->StreamInfo( ss );
+    }
+
+    geometryHash = HashString( ss.str() );
+    return geometryHash;
+}
+
+
+G4double GeometryManager::GetCubicVolume( G4VSolid* solid, G4int nStat ){
+
+    // Only boolean solids are estimated by Monte Carlo; other solids have analytic volumes.
+    //
+    if( nStat>0 && ( dynamic_cast<G4BooleanSolid*>( solid )!=0 || dynamic_cast<G4MultiUnion*>( solid )!=0 ) ){
+        return solid->EstimateCubicVolume( nStat, 0.001 );
+    }
+    return solid->GetCubicVolume();
+}
+
+
+G4double GeometryManager::GetMass( G4LogicalVolume* lv ){
+
+    if( massCacheLoaded==false ){
+        LoadMassCache();
+    }
+
+    auto itr = massCache.find( lv );
+    if( itr!=massCache.end() ){
+        return itr->second.mass;
+    }
+
+    G4LogicalVolumeStore* store = G4LogicalVolumeStore::GetInstance();
+
+    MassEntry entry;
+    entry.index = std::find( store->begin(), store->end(), lv ) - store->begin();
+    entry.name = lv->GetName();
+    entry.volume = lv->GetSolid()->GetCubicVolume();
+    entry.mass = lv->GetMass( false, false );
+    entry.nStat = 0;
+
+    massCache[lv] = entry;
+    massCacheModified = true;
+
+    return entry.mass;
 }
 
 
-G4ThreeVector GeometryManager::GetGlobalPosition( G4VPhysicalVolume* pv) {
+void GeometryManager::PrecomputeMass( G4int nStat ){
+
+    if( massCacheLoaded==false ){
+        LoadMassCache();
+    }
+
+    G4LogicalVolumeStore* store = G4LogicalVolumeStore::GetInstance();
+    for( size_t i=0; i<store->size(); i++ ){
+
+        G4LogicalVolume* lv = (*store)[i];
+
+        // Entries of the same or higher precision are kept.
+        //
+        auto itr = massCache.find( lv );
+        if( itr!=massCache.end() && itr->second.nStat>=nStat ){
+            continue;
+        }
+
+        // As in G4LogicalVolume::GetMass, daughters are subtracted with the density of the mother.
+        //
+        G4double volume = GetCubicVolume( lv->GetSolid(), nStat );
+        G4double net = volume;
+        for( size_t j=0; j<lv->GetNoDaughters(); j++ ){
+            G4VPhysicalVolume* daughter = lv->GetDaughter(j);
+            net -= daughter->GetMultiplicity() * GetCubicVolume( daughter->GetLogicalVolume()->GetSolid(), nStat );
+        }
+
+        MassEntry entry;
+        entry.index = i;
+        entry.name = lv->GetName();
+        entry.volume = volume;
+        entry.mass = net * lv->GetMaterial()->GetDensity();
+        entry.nStat = nStat;
+
+        G4cout << "GeometryManager: mass of " << entry.name << " is " << entry.mass/kg << " kg" << G4endl;
+
+        massCache[lv] = entry;
+        massCacheModified = true;
+    }
+
+    SaveMassCache();
+}
+
+
+// Each line of the cache file is: index in the logical volume store, name, volume (cm3), mass (kg), nStat.
+//
+void GeometryManager::LoadMassCache(){
+
+    massCacheLoaded = true;
+
+    if( cacheDirectory=="" ){
+        return;
+    }
+
+    std::string filename = cacheDirectory + "/" + GetGeometryHash() + ".mass";
+    std::ifstream file( filename );
+    if( !file.good() ){
+        return;
+    }
+
+    G4LogicalVolumeStore* store = G4LogicalVolumeStore::GetInstance();
+
+    MassEntry entry;
+    while( file >> entry.index >> entry.name >> entry.volume >> entry.mass >> entry.nStat ){
+
+        if( entry.index>=store->size() || (*store)[entry.index]->GetName()!=entry.name ){
+            G4cerr << "GeometryManager: " << filename << " does not match the geometry. Ignoring..." << G4endl;
+            massCache.clear();
+            return;
+        }
+
+        entry.volume *= cm3;
+        entry.mass *= kg;
+        massCache[ (*store)[entry.index] ] = entry;
+    }
+
+    G4cout << "GeometryManager: " << massCache.size() << " masses loaded from " << filename << G4endl;
+}
+
+
+void GeometryManager::SaveMassCache(){
+
+    if( cacheDirectory=="" || massCacheModified==false || geometryHash=="" ){
+        return;
+    }
+    massCacheModified = false;
+
+    // Written to a temporary file that is renamed, so that other jobs never read a partial file.
+    //
+    std::string filename = cacheDirectory + "/" + geometryHash + ".mass";
+    std::ostringstream tmp;
+    tmp << filename << ".tmp" << getpid();
 
-    /*
-    const G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
-    G4cout << "Tracing up the location of " << pv->GetName() << "\nTotal number of physical volumes: " << store->size() << std::endl; 
+    std::error_code error;
+    std::filesystem::create_directories( cacheDirectory, error );
+
+    std::vector<const MassEntry*> entries;
+    for( auto itr = massCache.begin(); itr!=massCache.end(); itr++ ){
+        entries.push_back( &(itr->second) );
+    }
+    std::sort( entries.begin(), entries.end(), []( const MassEntry* a, const MassEntry* b ){ return a->index < b->index; } );
 
-    for (const auto* volume : *store) {
-        std::cout << "Name: " << volume->GetName()
-                  << ", Copy No: " << volume->GetCopyNo()
-                  << ", Translation: " << volume->GetTranslation()/cm << " cm"
-                  << std::endl;
+    std::ofstream file( tmp.str() );
+    if( !file.good() ){
+        G4cerr << "GeometryManager: cannot write " << tmp.str() << G4endl;
+        return;
     }
-    */
 
-    G4ThreeVector position = pv->GetTranslation();
-    //G4cout << pv->GetName() << " translation is " << position << G4endl;
+    file.precision( 12 );
+    for( size_t i=0; i<entries.size(); i++ ){
+        file << entries[i]->index << ' ' << entries[i]->name << ' ' << entries[i]->volume/cm3 << ' ' << entries[i]->mass/kg << ' ' << entries[i]->nStat << '\n';
+    }
+    file.close();
+
+    std::rename( tmp.str().c_str(), filename.c_str() );
+}
+
 
-    //G4RotationMatrix rotation = *(pv->GetRotation()); // Copy rotation matrix if exists
-    // at the moment do not consiter rotation...
+void GeometryManager::CheckIndex(){
+    if( indexBuilt==false || G4PhysicalVolumeStore::GetInstance()->size()!=indexedVolumes ){
+        BuildIndex();
+    }
+}
 
-    G4VPhysicalVolume* mother = GetPhysicalVolume( pv->GetMotherLogical()->GetName() );
 
-    while ( mother != nullptr ) {
+// The hierarchy is walked from each volume without mother (the world and parallel worlds),
+// so that every placement path of a volume gets its own transformation.
+//
+void GeometryManager::BuildIndex(){
 
-        //G4cout << "Parent volume is " << mother->GetName() << " at " << mother->GetTranslation() << G4endl;
+    volumeIndex.clear();
+    transformIndex.clear();
 
-        if ( mother->GetName() == "World" ){
-            break;
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    for( auto itr = store->begin(); itr!=store->end(); itr++ ){
+        if( (*itr)->GetMotherLogical()==0 ){
+            IndexVolume( *itr, G4AffineTransform( (*itr)->GetRotation(), (*itr)->GetTranslation() ) );
         }
+    }
 
-        if (mother->GetRotation()) {
-            position = *(mother->GetRotation()) * position;
+    // Volumes not connected to a world are still found by name.
+    //
+    for( auto itr = store->begin(); itr!=store->end(); itr++ ){
+        if( transformIndex.find( *itr )==transformIndex.end() ){
+            volumeIndex[ (*itr)->GetName() ].push_back( *itr );
         }
+    }
+
+    indexedVolumes = store->size();
+    indexBuilt = true;
+}
 
-        position += mother->GetTranslation();
 
-        mother = GetPhysicalVolume( mother->GetMotherLogical()->GetName() );
-            // Note: it assumes logical volumes are unique
-            // Maybe in the future, also consider the copy number?
+void GeometryManager::IndexVolume( G4VPhysicalVolume* pv, const G4AffineTransform& transform ){
+
+    std::vector<G4AffineTransform>& transforms = transformIndex[pv];
+    if( transforms.empty() ){
+        volumeIndex[ pv->GetName() ].push_back( pv );
     }
+    transforms.push_back( transform );
+
+    G4LogicalVolume* lv = pv->GetLogicalVolume();
+    for( size_t i=0; i<lv->GetNoDaughters(); i++ ){
 
-    return position;
+        G4VPhysicalVolume* daughter = lv->GetDaughter(i);
+
+        // Daughter to mother, followed by mother to global.
+        // The frame rotation and translation are used as in G4NavigationHistory.
+        //
+        if( daughter->IsReplicated() ){
+            IndexReplicas( daughter, transform );
+        }
+        else{
+            IndexVolume( daughter, G4AffineTransform( daughter->GetRotation(), daughter->GetTranslation() ) * transform );
+        }
+    }
 }
 
 
+// Replicas and parameterised volumes are a single physical volume whose transformation is set per copy number.
+// Each copy is indexed as an instance of the volume, in the order of copy numbers.
+//
+void GeometryManager::IndexReplicas( G4VPhysicalVolume* pv, const G4AffineTransform& transform ){
+
+    G4VPVParameterisation* param = pv->GetParameterisation();
+    G4ReplicaNavigation replicaNavigation;
+
+    for( G4int copy=0; copy<pv->GetMultiplicity(); copy++ ){
+        if( param!=0 ){
+            param->ComputeTransformation( copy, pv );
+        }
+        else{
+            replicaNavigation.ComputeTransformation( copy, pv );
+        }
+        IndexVolume( pv, G4AffineTransform( pv->GetRotation(), pv->GetTranslation() ) * transform );
+    }
+}
+
 
 G4NistManager* GeometryManager::GetMaterialManager(){
     return G4NistManager::Instance();
@@ -308,10 +641,23 @@ void  GeometryManager::DefineMaterials( ){
 
 
 void GeometryManager::GeometryHasBeenModified(){
+    InvalidateIndex();
     G4RunManager::GetRunManager()->GeometryHasBeenModified();
 }
 
 
+void GeometryManager::SetParameter( G4String name, G4String value ){
+
+    config.RemoveParameter( name );
+
+    std::istringstream ss( value );
+    std::string token;
+    while( ss >> token ){
+        config.AddParameter( name, token );
+    }
+}
+
+
 void GeometryManager::LoadFile( G4String filename ){
     G4cout << "Loading parameters from " << filename << G4endl;
     config.LoadFile( filename );
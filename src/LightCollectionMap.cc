@@ -0,0 +1,429 @@
+/// \file LightCollectionMap.cc
+/// \brief Implementation of the LightCollectionMap class
+
+#include "LightCollectionMap.hh"
+#include "GeometryManager.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VTouchable.hh"
+#include "G4NavigationHistory.hh"
+#include "G4AffineTransform.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4OpticalSurface.hh"
+#include "G4LogicalBorderSurface.hh"
+#include "G4Poisson.hh"
+#include "Randomize.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+
+LightCollectionMap::LightCollectionMap( G4String output ) :
+    outputName( output ),
+    volume( 0 ),
+    nx( 0 ), ny( 0 ), nz( 0 ),
+    average( 0 ),
+    photonsPerEvent( 1000 ),
+    photonEnergy( 3*eV ),
+    lightYield( 38 ),
+    quantumEfficiency( 0.25 ),
+    nDetected( 0 )
+{}
+
+
+
+void LightCollectionMap::AddOpticalProperties(){
+
+    ConfigParser* config = const_cast<ConfigParser*>( GeometryManager::Get()->GetConfigParser() );
+
+    G4String crystalName = config->Find( "/optical/volume" ) ? config->GetString( "/optical/volume" ) : "NaICrystal";
+
+    vector<string> windows = config->GetStrArray( "/optical/windows" );
+    if( windows.empty() ){
+        windows.push_back( "GlassWindow" );
+        windows.push_back( "PMT" );
+    }
+
+    // Properties are flat over the emission band of NaI(Tl), around 415 nm.
+    //
+    std::vector<G4double> energies = { 2.0*eV, 4.0*eV };
+
+    G4double crystalIndex = config->GetDouble( "/optical/crystalIndex", 1.85 );
+    G4double windowIndex = config->GetDouble( "/optical/windowIndex", 1.47 );
+    G4double absorption = config->GetDouble( "/optical/absorptionLength", 100. )*cm;
+    G4double reflectivity = config->GetDouble( "/optical/reflectivity", 0.95 );
+
+    auto pvStore = G4PhysicalVolumeStore::GetInstance();
+    for( auto itr = pvStore->begin(); itr!=pvStore->end(); itr++ ){
+
+        G4VPhysicalVolume* pv = *itr;
+        G4Material* material = pv->GetLogicalVolume()->GetMaterial();
+
+        bool isWindow = std::find( windows.begin(), windows.end(), pv->GetName() )!=windows.end();
+        if( pv->GetName()!=crystalName && !isWindow ){
+            continue;
+        }
+
+        // Materials shared by several volumes get their properties once.
+        //
+        if( material->GetMaterialPropertiesTable()==0 ){
+            G4MaterialPropertiesTable* mpt = new G4MaterialPropertiesTable();
+            G4double index = isWindow ? windowIndex : crystalIndex;
+            mpt->AddProperty( "RINDEX", energies, { index, index } );
+            mpt->AddProperty( "ABSLENGTH", energies, { absorption, absorption } );
+            material->SetMaterialPropertiesTable( mpt );
+        }
+
+        if( isWindow ){
+            continue;
+        }
+
+        // The reflector wrapping the crystal is a painted surface towards each placement of its mother.
+        // Photons are reflected diffusely or absorbed, regardless of the material of the mother.
+        //
+        G4OpticalSurface* reflector = new G4OpticalSurface( "Reflector", unified, groundfrontpainted, dielectric_dielectric );
+        G4MaterialPropertiesTable* mpt = new G4MaterialPropertiesTable();
+        mpt->AddProperty( "REFLECTIVITY", energies, { reflectivity, reflectivity } );
+        reflector->SetMaterialPropertiesTable( mpt );
+
+        for( auto mother = pvStore->begin(); mother!=pvStore->end(); mother++ ){
+            if( (*mother)->GetLogicalVolume()==pv->GetMotherLogical() ){
+                new G4LogicalBorderSurface( "Reflector", pv, *mother, reflector );
+            }
+        }
+    }
+}
+
+
+
+void LightCollectionMap::Configure(){
+
+    ConfigParser* config = const_cast<ConfigParser*>( GeometryManager::Get()->GetConfigParser() );
+
+    volumeName = config->Find( "/optical/volume" ) ? config->GetString( "/optical/volume" ) : "NaICrystal";
+    photocathodeName = config->Find( "/optical/photocathode" ) ? config->GetString( "/optical/photocathode" ) : "PMT";
+
+    volume = GeometryManager::GetPhysicalVolume( volumeName );
+    if( volume==0 ){
+        G4Exception( "LightCollectionMap::Configure", "Optical001", FatalException,
+            ( "cannot find the crystal " + volumeName + " (optical/volume)." ).c_str() );
+        return;
+    }
+
+    G4ThreeVector pMin, pMax;
+    volume->GetLogicalVolume()->GetSolid()->BoundingLimits( pMin, pMax );
+
+    lightYield = config->GetDouble( "/optical/lightYield", 38. );
+    quantumEfficiency = config->GetDouble( "/optical/quantumEfficiency", 0.25 );
+
+    if( IsGenerating() ){
+
+        photonsPerEvent = config->GetInt( "/optical/photons", 1000 );
+        photonEnergy = config->GetDouble( "/optical/energy", 3. )*eV;
+
+        // Later runs add to the same map.
+        //
+        if( emitted.empty() ){
+            vector<int> bins = config->GetIntArray( "/optical/bins" );
+            nx = bins.size()>0 ? bins[0] : 10;
+            ny = bins.size()>1 ? bins[1] : 10;
+            nz = bins.size()>2 ? bins[2] : 20;
+            lower = pMin;
+            upper = pMax;
+            emitted.assign( nx*ny*nz, 0. );
+            detected.assign( nx*ny*nz, 0. );
+        }
+        return;
+    }
+
+    // In production, the map is loaded once.
+    //
+    G4String fileName = config->GetString( "/optical/map" );
+    if( fileName!=mapFile ){
+        Load( fileName );
+    }
+
+    if( ( pMin-lower ).mag()>0.01*mm || ( pMax-upper ).mag()>0.01*mm ){
+        G4cerr << GetClassName() << ": bounding box of " << volumeName << " differs from the map in " << mapFile
+            << ". The map may belong to another crystal." << G4endl;
+    }
+}
+
+
+
+void LightCollectionMap::GeneratePrimaries( G4Event* event ){
+
+    if( volume==0 ){
+        Configure();
+    }
+
+    // Uniform in the solid by rejection from its bounding box.
+    //
+    G4VSolid* solid = volume->GetLogicalVolume()->GetSolid();
+    do{
+        origin = G4ThreeVector( lower.x()+( upper.x()-lower.x() )*G4UniformRand(),
+                                lower.y()+( upper.y()-lower.y() )*G4UniformRand(),
+                                lower.z()+( upper.z()-lower.z() )*G4UniformRand() );
+    } while( solid->Inside( origin )!=kInside );
+
+    G4AffineTransform transform = GeometryManager::GetGlobalTransform( volume );
+
+    G4PrimaryVertex* vertex = new G4PrimaryVertex( transform.TransformPoint( origin ), 0. );
+
+    for( G4int i=0; i<photonsPerEvent; i++ ){
+
+        G4double cosTheta = 2*G4UniformRand()-1;
+        G4double sinTheta = std::sqrt( 1-cosTheta*cosTheta );
+        G4double phi = twopi*G4UniformRand();
+        G4ThreeVector direction( sinTheta*std::cos( phi ), sinTheta*std::sin( phi ), cosTheta );
+
+        G4ThreeVector polarization = direction.orthogonal().unit();
+        polarization.rotate( twopi*G4UniformRand(), direction );
+
+        G4PrimaryParticle* photon = new G4PrimaryParticle( G4OpticalPhoton::Definition() );
+        photon->SetKineticEnergy( photonEnergy );
+        photon->SetMomentumDirection( direction );
+        photon->SetPolarization( polarization );
+        vertex->SetPrimary( photon );
+    }
+
+    event->AddPrimaryVertex( vertex );
+
+    nDetected = 0;
+}
+
+
+
+void LightCollectionMap::Score( const G4Step* step ){
+
+    G4Track* track = step->GetTrack();
+    if( track->GetDefinition()!=G4OpticalPhoton::Definition() ){
+        return;
+    }
+
+    G4StepPoint* postStep = step->GetPostStepPoint();
+    if( postStep->GetStepStatus()==fGeomBoundary && postStep->GetPhysicalVolume()!=0
+            && postStep->GetPhysicalVolume()->GetName()==photocathodeName ){
+        nDetected++;
+        track->SetTrackStatus( fStopAndKill );
+    }
+}
+
+
+
+void LightCollectionMap::Fill( const G4Event* /*event*/ ){
+
+    G4int bin = GetBin( origin );
+    if( bin<0 ){
+        return;
+    }
+
+    emitted[bin] += photonsPerEvent;
+    detected[bin] += nDetected;
+}
+
+
+
+void LightCollectionMap::Save(){
+
+    std::ofstream file( outputName );
+    if( !file.good() ){
+        G4cerr << GetClassName() << ": cannot write the light collection map to " << outputName << G4endl;
+        return;
+    }
+
+    file << "# light collection map of " << volumeName << " to " << photocathodeName << '\n';
+    file << "# nx ny nz, lower and upper corner of the grid in local coordinates (mm)\n";
+    file << nx << ' ' << ny << ' ' << nz << ' '
+         << lower.x()/mm << ' ' << lower.y()/mm << ' ' << lower.z()/mm << ' '
+         << upper.x()/mm << ' ' << upper.y()/mm << ' ' << upper.z()/mm << '\n';
+    file << "# ix iy iz emitted detected\n";
+
+    for( G4int i=0; i<nx; i++ ){
+        for( G4int j=0; j<ny; j++ ){
+            for( G4int k=0; k<nz; k++ ){
+                G4int bin = ( i*ny+j )*nz+k;
+                file << i << ' ' << j << ' ' << k << ' ' << emitted[bin] << ' ' << detected[bin] << '\n';
+            }
+        }
+    }
+
+    G4cout << GetClassName() << ": light collection map written to " << outputName << G4endl;
+}
+
+
+
+void LightCollectionMap::Load( G4String fileName ){
+
+    std::ifstream file( fileName );
+    if( !file.good() ){
+        G4Exception( "LightCollectionMap::Load", "Optical002", FatalException,
+            ( "cannot read the light collection map " + fileName + " (optical/map)." ).c_str() );
+        return;
+    }
+
+    mapFile = fileName;
+    emitted.clear();
+    detected.clear();
+
+    G4double totalEmitted = 0;
+    G4double totalDetected = 0;
+
+    string line;
+    while( std::getline( file, line ) ){
+
+        if( line.empty() || line[0]=='#' ){
+            continue;
+        }
+
+        std::stringstream ss( line );
+
+        // The first line is the grid.
+        //
+        if( emitted.empty() ){
+            G4double x0, y0, z0, x1, y1, z1;
+            ss >> nx >> ny >> nz >> x0 >> y0 >> z0 >> x1 >> y1 >> z1;
+            lower = G4ThreeVector( x0, y0, z0 )*mm;
+            upper = G4ThreeVector( x1, y1, z1 )*mm;
+            emitted.assign( nx*ny*nz, 0. );
+            detected.assign( nx*ny*nz, 0. );
+            continue;
+        }
+
+        G4int i, j, k;
+        G4double e, d;
+        ss >> i >> j >> k >> e >> d;
+        if( ss.fail() || i<0 || i>=nx || j<0 || j>=ny || k<0 || k>=nz ){
+            continue;
+        }
+
+        emitted[( i*ny+j )*nz+k] = e;
+        detected[( i*ny+j )*nz+k] = d;
+        totalEmitted += e;
+        totalDetected += d;
+    }
+
+    average = totalEmitted>0 ? totalDetected/totalEmitted : 0;
+
+    G4cout << GetClassName() << ": light collection map " << fileName << " loaded, " << nx << 'x' << ny << 'x' << nz
+        << " bins, average efficiency " << average << G4endl;
+}
+
+
+
+G4int LightCollectionMap::GetPhotoelectrons( const G4Step* step ){
+
+    G4StepPoint* preStep = step->GetPreStepPoint();
+    if( step->GetTotalEnergyDeposit()<=0 || volume==0 || preStep->GetPhysicalVolume()->GetLogicalVolume()!=volume->GetLogicalVolume() ){
+        return 0;
+    }
+
+    // Deposit is attributed to the middle of the step, in the local coordinates of the crystal placement.
+    //
+    G4ThreeVector global = ( preStep->GetPosition()+step->GetPostStepPoint()->GetPosition() )/2;
+    G4ThreeVector local = preStep->GetTouchable()->GetHistory()->GetTopTransform().TransformPoint( global );
+
+    G4double mean = step->GetTotalEnergyDeposit()/keV * lightYield * GetEfficiency( local ) * quantumEfficiency;
+
+    return G4Poisson( mean );
+}
+
+
+
+G4double LightCollectionMap::GetEfficiency( const G4ThreeVector& local ) const {
+
+    G4int bin = GetBin( local );
+    if( bin<0 || emitted[bin]<=0 ){
+        return average;
+    }
+    return detected[bin]/emitted[bin];
+}
+
+
+
+G4int LightCollectionMap::GetBin( const G4ThreeVector& local ) const {
+
+    if( emitted.empty() ){
+        return -1;
+    }
+
+    G4int i = (G4int)( nx*( local.x()-lower.x() )/( upper.x()-lower.x() ) );
+    G4int j = (G4int)( ny*( local.y()-lower.y() )/( upper.y()-lower.y() ) );
+    G4int k = (G4int)( nz*( local.z()-lower.z() )/( upper.z()-lower.z() ) );
+
+    // Points on the upper faces belong to the last bin.
+    //
+    i = std::min( i, nx-1 );
+    j = std::min( j, ny-1 );
+    k = std::min( k, nz-1 );
+
+    if( i<0 || j<0 || k<0 ){
+        return -1;
+    }
+    return ( i*ny+j )*nz+k;
+}
+
+
+
+std::vector<G4String> LightCollectionMap::GetSummary(){
+
+    std::vector<G4String> summary;
+    std::stringstream ss;
+
+    ss << "volume " << volumeName;
+    summary.push_back( ss.str() );
+
+    ss.str("");
+    ss << "photocathode " << photocathodeName;
+    summary.push_back( ss.str() );
+
+    ss.str("");
+    ss << "bins " << nx << ' ' << ny << ' ' << nz;
+    summary.push_back( ss.str() );
+
+    if( IsGenerating() ){
+        G4double totalEmitted = 0;
+        G4double totalDetected = 0;
+        for( size_t i=0; i<emitted.size(); i++ ){
+            totalEmitted += emitted[i];
+            totalDetected += detected[i];
+        }
+
+        ss.str("");
+        ss << "output " << outputName;
+        summary.push_back( ss.str() );
+
+        ss.str("");
+        ss << "emitted " << totalEmitted << " detected " << totalDetected;
+        summary.push_back( ss.str() );
+    }
+    else{
+        ss.str("");
+        ss << "map " << mapFile;
+        summary.push_back( ss.str() );
+
+        ss.str("");
+        ss << "averageEfficiency " << average;
+        summary.push_back( ss.str() );
+
+        ss.str("");
+        ss << "lightYield " << lightYield << " /keV; quantumEfficiency " << quantumEfficiency;
+        summary.push_back( ss.str() );
+    }
+
+    return summary;
+}
@@ -0,0 +1,404 @@
+/// \file LineOfSight.cc
+/// \brief Implementation of the LineOfSight class
+
+#include "LineOfSight.hh"
+#include "GeometryManager.hh"
+
+#include "G4Navigator.hh"
+#include "G4TransportationManager.hh"
+#include "G4GeometryManager.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4Material.hh"
+#include "G4EmCalculator.hh"
+#include "G4RunManagerKernel.hh"
+#include "G4Gamma.hh"
+#include "G4GeometryWorkspace.hh"
+#include "G4SolidsWorkspace.hh"
+#include "Randomize.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <thread>
+#include <mutex>
+#include <cmath>
+#include <cfloat>
+#include <sstream>
+#include <algorithm>
+
+
+LineOfSight::LineOfSight() : world( 0 ){}
+
+
+
+void LineOfSight::Run( G4int nRays ){
+
+    summary.clear();
+
+    ConfigParser* config = const_cast<ConfigParser*>( GeometryManager::Get()->GetConfigParser() );
+
+    if( nRays<=0 ){
+        nRays = config->GetInt( "/attenuation/rays", 1000000 );
+    }
+
+    world = G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume();
+    if( world==0 ){
+        G4cerr << GetClassName() << ": geometry is not initialized. Run /run/initialize first." << G4endl;
+        return;
+    }
+
+    // G4EmCalculator needs the physics tables. The kernel builds them without starting a run,
+    // so no run is added to the output. Voxels of a closed geometry speed up the navigation.
+    //
+    G4RunManagerKernel* kernel = G4RunManagerKernel::GetRunManagerKernel();
+    if( kernel->RunInitialization() ){
+        kernel->RunTermination();
+    }
+    if( !G4GeometryManager::GetInstance()->IsGeometryClosed() ){
+        G4GeometryManager::GetInstance()->CloseGeometry( true );
+    }
+
+    // Source material and detector volume
+    //
+    G4String materialName = config->GetString( "/attenuation/source" );
+    G4String detectorName = config->GetString( "/attenuation/detector" );
+
+    G4Material* material = G4Material::GetMaterial( materialName, false );
+    if( material==0 ){
+        G4cerr << GetClassName() << ": cannot find source material '" << materialName << "' (attenuation/source)." << G4endl;
+        return;
+    }
+
+    source = Sampler();
+    detector = Sampler();
+
+    bool replicated = false;
+
+    auto pvStore = G4PhysicalVolumeStore::GetInstance();
+    for( auto itr = pvStore->begin(); itr!=pvStore->end(); itr++ ){
+        if( (*itr)->IsReplicated() ){
+            replicated = true;
+            continue;
+                // replicas share one physical volume whose position is set during navigation
+        }
+        if( (*itr)->GetLogicalVolume()->GetMaterial()==material ){
+            AddRegion( source, *itr );
+        }
+        if( (*itr)->GetName()==detectorName ){
+            AddRegion( detector, *itr );
+        }
+    }
+
+    if( source.regions.empty() || detector.regions.empty() ){
+        G4cerr << GetClassName() << ": no volume of " << materialName << " or no detector '" << detectorName
+            << "' (attenuation/detector) outside replicas." << G4endl;
+        return;
+    }
+
+    // Gamma lines of the isotopes, with emission density per line
+    //
+    isotopes.clear();
+    isotopeOfLine.clear();
+    energies.clear();
+    intensities.clear();
+    emission.clear();
+
+    const string prefix = "/attenuation/isotopes/";
+    map< string, vector<string> > list = config->GetListOfParameters( prefix );
+    for( auto itr = list.begin(); itr!=list.end(); itr++ ){
+
+        string dir = itr->first;
+        if( *dir.rbegin()!='/' ){
+            continue;
+        }
+
+        G4double activity = config->GetDouble( dir+"activity", 0. );
+        vector<double> lines = config->GetDoubleArray( dir+"lines" );
+        vector<double> yields = config->GetDoubleArray( dir+"intensities" );
+
+        if( lines.empty() || lines.size()!=yields.size() ){
+            G4cerr << GetClassName() << ": " << dir << " needs lines and the same number of intensities. Skipping..." << G4endl;
+            continue;
+        }
+
+        isotopes.push_back( dir.substr( prefix.size(), dir.size()-prefix.size()-1 ) );
+
+        for( size_t i=0; i<lines.size(); i++ ){
+            isotopeOfLine.push_back( isotopes.size()-1 );
+            energies.push_back( lines[i]*keV );
+            intensities.push_back( yields[i] );
+            emission.push_back( activity * yields[i] * material->GetDensity()/(kg/mm3) );
+        }
+    }
+
+    if( energies.empty() ){
+        G4cerr << GetClassName() << ": no gamma lines under attenuation/isotopes." << G4endl;
+        return;
+    }
+
+    // Attenuation coefficients of the materials in the geometry.
+    // G4EmCalculator is not thread-safe, so they are computed here.
+    //
+    mu.assign( G4Material::GetNumberOfMaterials(), std::vector<G4double>( energies.size(), 0 ) );
+
+    G4EmCalculator calculator;
+    std::vector<bool> done( G4Material::GetNumberOfMaterials(), false );
+
+    auto lvStore = G4LogicalVolumeStore::GetInstance();
+    for( auto itr = lvStore->begin(); itr!=lvStore->end(); itr++ ){
+        const G4Material* mat = (*itr)->GetMaterial();
+        if( done[ mat->GetIndex() ] ){
+            continue;
+        }
+        done[ mat->GetIndex() ] = true;
+        for( size_t l=0; l<energies.size(); l++ ){
+            G4double length = calculator.ComputeGammaAttenuationLength( energies[l], mat );
+            mu[ mat->GetIndex() ][l] = length>0 && length<DBL_MAX ? 1./length : 0;
+        }
+    }
+
+    G4int nThreads = config->GetInt( "/attenuation/threads", (int)std::max( 1u, std::thread::hardware_concurrency() ) );
+    if( replicated && nThreads>1 ){
+        G4cerr << GetClassName() << ": geometry has replicated volumes, which cannot be navigated concurrently. Using one thread." << G4endl;
+        nThreads = 1;
+    }
+    nThreads = std::max( 1, std::min( nThreads, nRays ) );
+
+    G4cout << GetClassName() << ": tracing " << nRays << " rays from " << materialName << " to " << detectorName
+        << " with " << nThreads << " threads..." << G4endl;
+
+    std::vector<Tally> tallies( nThreads );
+    std::vector<std::thread> workers;
+
+    for( G4int t=0; t<nThreads; t++ ){
+        G4int n = nRays/nThreads + ( t < nRays%nThreads ? 1 : 0 );
+        unsigned long seed = (unsigned long)( G4UniformRand()*4294967296. );
+        if( nThreads==1 ){
+            Work( n, seed, tallies[t] );
+        }
+        else{
+            workers.push_back( std::thread( &LineOfSight::WorkInThread, this, n, seed, std::ref( tallies[t] ) ) );
+        }
+    }
+    for( size_t t=0; t<workers.size(); t++ ){
+        workers[t].join();
+    }
+
+    // Merge the threads
+    //
+    Tally total;
+    total.sum.assign( energies.size(), 0 );
+    total.sum2.assign( energies.size(), 0 );
+    for( size_t t=0; t<tallies.size(); t++ ){
+        for( size_t l=0; l<energies.size(); l++ ){
+            total.sum[l] += tallies[t].sum[l];
+            total.sum2[l] += tallies[t].sum2[l];
+        }
+        total.accepted += tallies[t].accepted;
+        total.attempts += tallies[t].attempts;
+    }
+
+    if( total.accepted==0 ){
+        G4cerr << GetClassName() << ": no ray could be traced." << G4endl;
+        return;
+    }
+
+    G4double volume = source.boxVolume * total.accepted / total.attempts;
+    G4double n = total.accepted;
+
+    G4cout << GetClassName() << ": source volume " << volume/cm3 << " cm3, " << total.accepted << " rays" << G4endl;
+
+    summary.push_back( "# isotope line_keV intensity flux_per_cm2_s error" );
+
+    std::vector<G4double> isotopeFlux( isotopes.size(), 0 );
+    std::vector<G4double> isotopeVar( isotopes.size(), 0 );
+
+    for( size_t l=0; l<energies.size(); l++ ){
+
+        G4double mean = total.sum[l]/n;
+        G4double var = std::max( 0., total.sum2[l]/n - mean*mean )/n;
+
+        G4double flux = emission[l] * volume * mean * cm2;
+        G4double error = emission[l] * volume * std::sqrt( var ) * cm2;
+
+        isotopeFlux[ isotopeOfLine[l] ] += flux;
+        isotopeVar[ isotopeOfLine[l] ] += error*error;
+            // lines are correlated through the rays, so the total error is approximate
+
+        std::stringstream ss;
+        ss << isotopes[ isotopeOfLine[l] ] << ' ' << energies[l]/keV << ' ' << intensities[l] << ' ' << flux << ' ' << error;
+        summary.push_back( ss.str() );
+    }
+
+    for( size_t i=0; i<isotopes.size(); i++ ){
+        std::stringstream ss;
+        ss << isotopes[i] << " total - " << isotopeFlux[i] << ' ' << std::sqrt( isotopeVar[i] );
+        summary.push_back( ss.str() );
+    }
+
+    for( size_t i=0; i<summary.size(); i++ ){
+        G4cout << GetClassName() << ": " << summary[i] << '\n';
+    }
+    G4cout << G4endl;
+}
+
+
+
+void LineOfSight::AddRegion( Sampler& sampler, G4VPhysicalVolume* pv ){
+
+    G4ThreeVector min, max;
+    pv->GetLogicalVolume()->GetSolid()->BoundingLimits( min, max );
+
+    G4double boxVolume = (max-min).x() * (max-min).y() * (max-min).z();
+
+    for( size_t i=0; i<GeometryManager::GetNumberOfInstances( pv ); i++ ){
+        Region region;
+        region.pv = pv;
+        region.transform = GeometryManager::GetGlobalTransform( pv, i );
+        region.min = min;
+        region.max = max;
+        sampler.regions.push_back( region );
+
+        sampler.boxVolume += boxVolume;
+        sampler.cdf.push_back( sampler.boxVolume );
+    }
+}
+
+
+
+bool LineOfSight::Sample( const Sampler& sampler, G4Navigator* navigator, std::mt19937_64& rng, G4ThreeVector& point, long& attempts ){
+
+    std::uniform_real_distribution<G4double> uniform( 0., 1. );
+
+    for( int i=0; i<100000; i++ ){
+
+        attempts++;
+
+        size_t index = std::lower_bound( sampler.cdf.begin(), sampler.cdf.end(), uniform( rng )*sampler.boxVolume ) - sampler.cdf.begin();
+        const Region& region = sampler.regions[ std::min( index, sampler.regions.size()-1 ) ];
+
+        G4ThreeVector local( region.min.x() + uniform( rng )*( region.max.x()-region.min.x() ),
+                             region.min.y() + uniform( rng )*( region.max.y()-region.min.y() ),
+                             region.min.z() + uniform( rng )*( region.max.z()-region.min.z() ) );
+
+        if( region.pv->GetLogicalVolume()->GetSolid()->Inside( local )==kOutside ){
+            continue;
+        }
+
+        // the point should not be in a daughter
+        //
+        G4ThreeVector global = region.transform.TransformPoint( local );
+        if( navigator->LocateGlobalPointAndSetup( global, 0, false, true )!=region.pv ){
+            continue;
+        }
+
+        point = global;
+        return true;
+    }
+    return false;
+}
+
+
+
+void LineOfSight::Trace( G4Navigator* navigator, const G4ThreeVector& start, const G4ThreeVector& end, std::vector<G4double>& tau ){
+
+    G4ThreeVector direction = ( end-start ).unit();
+    G4double remaining = ( end-start ).mag();
+    G4ThreeVector point = start;
+
+    G4VPhysicalVolume* pv = navigator->LocateGlobalPointAndSetup( point, &direction, false, false );
+
+    for( int i=0; i<100000 && pv!=0 && remaining>0; i++ ){
+
+        G4double safety = 0;
+        G4double step = std::min( navigator->ComputeStep( point, direction, remaining, safety ), remaining );
+
+        const std::vector<G4double>& coefficients = mu[ pv->GetLogicalVolume()->GetMaterial()->GetIndex() ];
+        for( size_t l=0; l<tau.size(); l++ ){
+            tau[l] += coefficients[l]*step;
+        }
+
+        remaining -= step;
+        point += step*direction;
+
+        navigator->SetGeometricallyLimitedStep();
+        pv = navigator->LocateGlobalPointAndSetup( point, &direction, true );
+    }
+}
+
+
+
+// Workspaces read the master data of all volumes, so they are set up one thread at a time.
+//
+static std::mutex workspaceMutex;
+
+
+void LineOfSight::WorkInThread( G4int nRays, unsigned long seed, Tally& tally ){
+
+#ifdef G4MULTITHREADED
+    // Solids, materials and replica positions are thread-local in multi-threaded builds.
+    // They are copied from the master here, as in the worker threads of Geant4.
+    //
+    G4GeometryWorkspace* geometryWorkspace = 0;
+    G4SolidsWorkspace* solidsWorkspace = 0;
+    {
+        std::lock_guard<std::mutex> lock( workspaceMutex );
+        geometryWorkspace = new G4GeometryWorkspace();
+        solidsWorkspace = new G4SolidsWorkspace();
+    }
+#endif
+
+    Work( nRays, seed, tally );
+
+#ifdef G4MULTITHREADED
+    {
+        std::lock_guard<std::mutex> lock( workspaceMutex );
+        solidsWorkspace->DestroyWorkspace();
+        geometryWorkspace->DestroyWorkspace();
+        delete solidsWorkspace;
+        delete geometryWorkspace;
+    }
+#endif
+}
+
+
+
+void LineOfSight::Work( G4int nRays, unsigned long seed, Tally& tally ){
+
+    G4Navigator navigator;
+    navigator.SetWorldVolume( world );
+    navigator.SetPushVerbosity( false );
+
+    std::mt19937_64 rng( seed );
+
+    tally.sum.assign( energies.size(), 0 );
+    tally.sum2.assign( energies.size(), 0 );
+
+    std::vector<G4double> tau( energies.size() );
+
+    long detectorAttempts = 0;
+
+    for( G4int i=0; i<nRays; i++ ){
+
+        G4ThreeVector start, end;
+        if( !Sample( source, &navigator, rng, start, tally.attempts ) || !Sample( detector, &navigator, rng, end, detectorAttempts ) ){
+            break;
+        }
+        tally.accepted++;
+
+        std::fill( tau.begin(), tau.end(), 0 );
+        Trace( &navigator, start, end, tau );
+
+        G4double geometry = 1./( 4*pi*( end-start ).mag2() );
+
+        for( size_t l=0; l<tau.size(); l++ ){
+            G4double f = std::exp( -tau[l] ) * geometry;
+            tally.sum[l] += f;
+            tally.sum2[l] += f*f;
+        }
+    }
+}
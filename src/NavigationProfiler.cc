@@ -0,0 +1,138 @@
+/// \file NavigationProfiler.cc
+/// \brief Implementation of the NavigationProfiler class
+
+#include "NavigationProfiler.hh"
+
+#include "G4TransportationManager.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4SmartVoxelHeader.hh"
+#include "G4SmartVoxelProxy.hh"
+
+#include <chrono>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+
+NavigationProfiler* NavigationProfiler::profiler = 0;
+
+
+NavigationProfiler::NavigationProfiler() : G4Navigator(){}
+
+
+
+NavigationProfiler* NavigationProfiler::Enable(){
+    if( !profiler ){
+        profiler = new NavigationProfiler();
+        G4TransportationManager::GetTransportationManager()->SetNavigatorForTracking( profiler );
+    }
+    return profiler;
+}
+
+
+
+G4VPhysicalVolume* NavigationProfiler::LocateGlobalPointAndSetup( const G4ThreeVector& point, const G4ThreeVector* direction,
+                                                                  const G4bool pRelativeSearch, const G4bool ignoreDirection ){
+
+    auto start = std::chrono::steady_clock::now();
+
+    G4VPhysicalVolume* pv = G4Navigator::LocateGlobalPointAndSetup( point, direction, pRelativeSearch, ignoreDirection );
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    // the volume found was searched among the daughters of its mother
+    //
+    G4int depth = fHistory.GetDepth();
+    G4VPhysicalVolume* mother = depth>0 ? fHistory.GetVolume( depth-1 ) : pv;
+
+    if( mother!=0 ){
+        NavigationCost& cost = costs[ mother->GetLogicalVolume() ];
+        cost.locateCalls++;
+        cost.locateTime += elapsed.count();
+    }
+
+    return pv;
+}
+
+
+
+G4double NavigationProfiler::ComputeStep( const G4ThreeVector& pGlobalPoint, const G4ThreeVector& pDirection,
+                                          const G4double pCurrentProposedStepLength, G4double& pNewSafety ){
+
+    G4VPhysicalVolume* current = fHistory.GetTopVolume();
+
+    auto start = std::chrono::steady_clock::now();
+
+    G4double step = G4Navigator::ComputeStep( pGlobalPoint, pDirection, pCurrentProposedStepLength, pNewSafety );
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if( current!=0 ){
+        NavigationCost& cost = costs[ current->GetLogicalVolume() ];
+        cost.stepCalls++;
+        cost.stepTime += elapsed.count();
+    }
+
+    return step;
+}
+
+
+
+G4int NavigationProfiler::CountVoxels( G4SmartVoxelHeader* header ){
+
+    if( header==0 ){
+        return 0;
+    }
+
+    // Consecutive slices with the same contents share one proxy.
+    //
+    G4int n = 0;
+    G4SmartVoxelProxy* previous = 0;
+
+    for( size_t i=0; i<header->GetNoSlices(); i++ ){
+        G4SmartVoxelProxy* proxy = header->GetSlice( i );
+        if( proxy==previous ){
+            continue;
+        }
+        previous = proxy;
+        n += proxy->IsHeader() ? CountVoxels( proxy->GetHeader() ) : 1;
+    }
+    return n;
+}
+
+
+
+std::vector<G4String> NavigationProfiler::GetReport(){
+
+    std::vector< G4LogicalVolume* > volumes;
+
+    auto store = G4LogicalVolumeStore::GetInstance();
+    for( auto itr = store->begin(); itr!=store->end(); itr++ ){
+        if( (*itr)->GetNoDaughters()>0 || costs.find( *itr )!=costs.end() ){
+            volumes.push_back( *itr );
+        }
+    }
+
+    std::sort( volumes.begin(), volumes.end(), [this]( G4LogicalVolume* a, G4LogicalVolume* b ){
+        const NavigationCost& ca = costs[a];
+        const NavigationCost& cb = costs[b];
+        return ca.locateTime+ca.stepTime > cb.locateTime+cb.stepTime;
+    });
+
+    std::vector<G4String> lines;
+    lines.push_back( "# volume daughters voxels locateCalls locateTime_s stepCalls stepTime_s" );
+
+    for( auto itr = volumes.begin(); itr!=volumes.end(); itr++ ){
+        const NavigationCost& cost = costs[*itr];
+
+        std::stringstream ss;
+        ss << (*itr)->GetName() << ' ' << (*itr)->GetNoDaughters() << ' ' << CountVoxels( (*itr)->GetVoxelHeader() ) << ' '
+           << cost.locateCalls << ' ' << std::setprecision(4) << cost.locateTime << ' '
+           << cost.stepCalls << ' ' << cost.stepTime;
+        lines.push_back( ss.str() );
+    }
+
+    return lines;
+}
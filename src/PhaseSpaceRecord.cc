@@ -0,0 +1,108 @@
+/// \file PhaseSpaceRecord.cc
+/// \brief Implementation of the PhaseSpaceRecord class
+
+#include "PhaseSpaceRecord.hh"
+
+#include "G4StepPoint.hh"
+#include "G4Track.hh"
+#include "G4EventManager.hh"
+#include "G4Event.hh"
+#include "G4ParticleTable.hh"
+#include "G4IonTable.hh"
+
+#include "G4SystemOfUnits.hh"
+
+
+PhaseSpaceRecord::PhaseSpaceRecord()
+  : eventID(-1),
+    pdg(0),
+    x(0), y(0), z(0),
+    px(0), py(0), pz(0),
+    E(0),
+    t(0),
+    w(1)
+{}
+
+
+void PhaseSpaceRecord::Branch( TTree* tree ){
+    tree->Branch("eventID", &eventID, "eventID/I");
+    tree->Branch("pdg", &pdg, "pdg/I");
+    tree->Branch("x", &x, "x/F");
+    tree->Branch("y", &y, "y/F");
+    tree->Branch("z", &z, "z/F");
+    tree->Branch("px", &px, "px/F");
+    tree->Branch("py", &py, "py/F");
+    tree->Branch("pz", &pz, "pz/F");
+    tree->Branch("E", &E, "E/F");
+    tree->Branch("t", &t, "t/D");
+    tree->Branch("w", &w, "w/F");
+}
+
+
+void PhaseSpaceRecord::SetBranchAddress( TTree* tree ){
+    tree->SetBranchAddress("eventID", &eventID);
+    tree->SetBranchAddress("pdg", &pdg);
+    tree->SetBranchAddress("x", &x);
+    tree->SetBranchAddress("y", &y);
+    tree->SetBranchAddress("z", &z);
+    tree->SetBranchAddress("px", &px);
+    tree->SetBranchAddress("py", &py);
+    tree->SetBranchAddress("pz", &pz);
+    tree->SetBranchAddress("E", &E);
+    tree->SetBranchAddress("t", &t);
+    tree->SetBranchAddress("w", &w);
+}
+
+
+void PhaseSpaceRecord::Fill( const G4Step* step ){
+
+    G4StepPoint* postStep = step->GetPostStepPoint();
+
+    eventID = G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID();
+    pdg = step->GetTrack()->GetParticleDefinition()->GetPDGEncoding();
+
+    x = postStep->GetPosition().x()/mm;
+    y = postStep->GetPosition().y()/mm;
+    z = postStep->GetPosition().z()/mm;
+
+    px = postStep->GetMomentumDirection().x();
+    py = postStep->GetMomentumDirection().y();
+    pz = postStep->GetMomentumDirection().z();
+
+    E = postStep->GetKineticEnergy()/keV;
+    t = postStep->GetGlobalTime()/ns;
+    w = postStep->GetWeight();
+}
+
+
+G4ParticleDefinition* PhaseSpaceRecord::GetParticleDefinition(){
+
+    G4ParticleDefinition* def = G4ParticleTable::GetParticleTable()->FindParticle( pdg );
+
+    // Ions are not in the particle table until they are created.
+    //
+    if( def==0 ){
+        def = G4IonTable::GetIonTable()->GetIon( pdg );
+    }
+    return def;
+}
+
+
+G4ThreeVector PhaseSpaceRecord::GetPosition(){
+    return G4ThreeVector( x, y, z )*mm;
+}
+
+
+G4ThreeVector PhaseSpaceRecord::GetMomentumDir(){
+    return G4ThreeVector( px, py, pz ).unit();
+}
+
+
+G4double PhaseSpaceRecord::GetEnergy(){
+    return E*keV;
+}
+
+
+G4double PhaseSpaceRecord::GetTime(){
+    return t*ns;
+}
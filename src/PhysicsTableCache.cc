@@ -0,0 +1,230 @@
+/// \file PhysicsTableCache.cc
+/// \brief Implementation of the PhysicsTableCache class
+
+#include "PhysicsTableCache.hh"
+#include "utility.hh"
+
+#include "G4RunManager.hh"
+#include "G4VUserPhysicsList.hh"
+#include "G4RegionStore.hh"
+#include "G4Region.hh"
+#include "G4ProductionCuts.hh"
+#include "G4Material.hh"
+#include "G4Element.hh"
+#include "G4EmParameters.hh"
+#include "G4Version.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <map>
+#include <cstdint>
+#include <unistd.h>
+
+
+namespace fs = std::filesystem;
+
+static const std::string keyFileName = "cache.key";
+
+
+PhysicsTableCache* PhysicsTableCache::cache = 0;
+
+
+PhysicsTableCache* PhysicsTableCache::Get(){
+    if( !cache ){
+        cache = new PhysicsTableCache();
+    }
+    return cache;
+}
+
+
+PhysicsTableCache::PhysicsTableCache(){
+    pending = false;
+}
+
+
+void PhysicsTableCache::SetDirectory( G4String dir, G4String physics ){
+    directory = dir;
+    physicsName = physics;
+}
+
+
+std::string PhysicsTableCache::BuildKey(){
+
+    std::ostringstream key;
+    key << std::setprecision(12);
+
+    key << "geant4 " << G4Version << "\n";
+    key << "physics " << physicsName << "\n";
+
+    const G4VUserPhysicsList* physicsList = G4RunManager::GetRunManager()->GetUserPhysicsList();
+    key << "defaultCut " << physicsList->GetDefaultCutValue()/mm << "\n";
+
+    // Regions in order of creation. The default region gets its cuts from the default cut above.
+    //
+    G4RegionStore* regions = G4RegionStore::GetInstance();
+    for( auto itr = regions->begin(); itr!=regions->end(); itr++ ){
+        key << "region " << (*itr)->GetName();
+        G4ProductionCuts* cuts = (*itr)->GetProductionCuts();
+        if( cuts!=0 ){
+            key << " " << cuts->GetProductionCut("gamma")/mm << " " << cuts->GetProductionCut("e-")/mm
+                << " " << cuts->GetProductionCut("e+")/mm << " " << cuts->GetProductionCut("proton")/mm;
+        }
+        key << "\n";
+    }
+
+    // EM options that change the tables, e.g. set by the physics constructors or /process/em and /process/msc.
+    //
+    const G4EmParameters* em = G4EmParameters::Instance();
+    key << "emEnergy " << em->MinKinEnergy()/keV << " " << em->MaxKinEnergy()/keV << " " << em->NumberOfBinsPerDecade()
+        << " " << em->LowestElectronEnergy()/keV << " " << em->LowestMuHadEnergy()/keV << "\n";
+    key << "emLoss " << em->LinearLossLimit() << " " << em->BuildCSDARange() << " " << em->LossFluctuation()
+        << " " << em->UseCutAsFinalRange() << " " << em->ApplyCuts() << " " << em->GeneralProcessActive() << "\n";
+    key << "msc " << em->MscStepLimitType() << " " << em->MscMuHadStepLimitType() << " " << em->MscRangeFactor()
+        << " " << em->MscGeomFactor() << " " << em->MscSkin() << " " << em->MscThetaLimit() << " " << em->MscEnergyLimit()/MeV
+        << " " << em->LateralDisplacement() << " " << em->UseMottCorrection() << "\n";
+    key << "deexcitation " << em->Fluo() << " " << em->Auger() << " " << em->Pixe() << " " << em->DeexcitationIgnoreCut() << "\n";
+
+    const std::vector<G4String>& emRegions = G4EmParameters::Instance()->RegionsPhysics();
+    const std::vector<G4String>& emTypes = G4EmParameters::Instance()->TypesPhysics();
+    for( size_t i=0; i<emRegions.size() && i<emTypes.size(); i++ ){
+        key << "em " << emRegions[i] << " " << emTypes[i] << "\n";
+    }
+
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    for( auto itr = materials->begin(); itr!=materials->end(); itr++ ){
+        key << "material " << (*itr)->GetName() << " " << (*itr)->GetDensity()/(g/cm3) << " " << (*itr)->GetState()
+            << " " << (*itr)->GetTemperature()/kelvin << " " << (*itr)->GetPressure()/atmosphere;
+        for( size_t i=0; i<(*itr)->GetNumberOfElements(); i++ ){
+            key << " " << (*itr)->GetElement(i)->GetZ() << ":" << (*itr)->GetElement(i)->GetN() << ":" << (*itr)->GetFractionVector()[i];
+        }
+        key << "\n";
+    }
+
+    return key.str();
+}
+
+
+void PhysicsTableCache::Prepare(){
+
+    pending = false;
+
+    if( !Enabled() ){
+        return;
+    }
+
+    currentKey = BuildKey();
+
+    // Hash of the key names the sub-directory.
+    //
+    currentDir = directory + "/" + HashString( currentKey );
+
+    G4VUserPhysicsList* physicsList = const_cast<G4VUserPhysicsList*>( G4RunManager::GetRunManager()->GetUserPhysicsList() );
+
+    if( Verify( currentDir, currentKey ) ){
+        G4cout << GetClassName() << ": retrieving physics tables from " << currentDir << G4endl;
+        physicsList->SetPhysicsTableRetrieved( currentDir );
+    }
+    else{
+        G4cout << GetClassName() << ": no valid physics tables in " << currentDir << ", building them." << G4endl;
+        physicsList->ResetPhysicsTableRetrieved();
+        pending = true;
+    }
+}
+
+
+bool PhysicsTableCache::Verify( const std::string& dir, const std::string& key ){
+
+    std::ifstream file( dir + "/" + keyFileName );
+    if( !file.good() ){
+        return false;
+    }
+
+    // Key file has the number of key characters, the key and a list of table files with their sizes.
+    //
+    size_t length = 0;
+    file >> length;
+    file.ignore( 1, '\n' );
+
+    std::string stored( length, '\0' );
+    file.read( &stored[0], length );
+    if( !file.good() || stored!=key ){
+        if( file.good() ){
+            G4cout << GetClassName() << ": key of " << dir << " does not match." << G4endl;
+        }
+        return false;
+    }
+
+    std::string name;
+    uintmax_t size;
+    while( file >> name >> size ){
+        std::error_code error;
+        if( fs::file_size( dir + "/" + name, error )!=size || error ){
+            G4cerr << GetClassName() << ": table file " << name << " in " << dir << " is missing or incomplete." << G4endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void PhysicsTableCache::Store(){
+
+    if( !Enabled() || pending==false ){
+        return;
+    }
+    pending = false;
+
+    // Tables are written to a temporary directory that is renamed at the end,
+    // so that jobs sharing the cache never see a partially written directory.
+    //
+    std::ostringstream tmp;
+    tmp << currentDir << ".tmp" << getpid();
+
+    std::error_code error;
+    fs::create_directories( tmp.str(), error );
+    if( error ){
+        G4cerr << GetClassName() << ": cannot create " << tmp.str() << ": " << error.message() << G4endl;
+        return;
+    }
+
+    G4VUserPhysicsList* physicsList = const_cast<G4VUserPhysicsList*>( G4RunManager::GetRunManager()->GetUserPhysicsList() );
+    if( physicsList->StorePhysicsTable( tmp.str() )==false ){
+        G4cerr << GetClassName() << ": failed to store physics tables." << G4endl;
+        fs::remove_all( tmp.str(), error );
+        return;
+    }
+
+    std::map<std::string, uintmax_t> files;
+    for( auto& entry : fs::directory_iterator( tmp.str() ) ){
+        if( entry.is_regular_file() ){
+            files[ entry.path().filename().string() ] = entry.file_size();
+        }
+    }
+
+    std::ofstream file( tmp.str() + "/" + keyFileName );
+    file << currentKey.size() << "\n" << currentKey;
+    for( auto itr = files.begin(); itr!=files.end(); itr++ ){
+        file << itr->first << " " << itr->second << "\n";
+    }
+    file.close();
+
+    // A directory that failed verification is replaced.
+    //
+    if( fs::exists( currentDir, error ) && Verify( currentDir, currentKey )==false ){
+        fs::remove_all( currentDir, error );
+    }
+
+    fs::rename( tmp.str(), currentDir, error );
+    if( error ){
+        // Another job stored the same tables first.
+        //
+        fs::remove_all( tmp.str(), error );
+        return;
+    }
+
+    G4cout << GetClassName() << ": physics tables stored in " << currentDir << G4endl;
+}
@@ -9,6 +9,9 @@
 
 
 #include "RunAction.hh"
+#include "PhysicsTableCache.hh"
+#include "NavigationProfiler.hh"
+#include "GeometryManager.hh"
 #include "RunActionMessenger.hh"
 
 #include "G4Run.hh"
@@ -20,10 +23,12 @@
 #include "TFile.h"
 #include "TTree.h"
 
+#include <algorithm>
+
 
 RunAction::RunAction( CommandlineArguments* c) : G4UserRunAction(), fRunActionMessenger(0), fCmdlArgs( c ){
 
-    version = "1.0.2";
+    version = "1.1.0";
         // Version number. Do not change.
         // Backward compatible should increment minor number
         // Bug fixes should increment patch number
@@ -64,6 +69,18 @@ RunAction::RunAction( CommandlineArguments* c) : G4UserRunAction(), fRunActionMe
 
     outputFile = 0;
     dataTree = 0;
+    phaseSpaceTree = 0;
+
+    adjointTree = 0;
+    adjointScorer = 0;
+
+    earlyAbort = 0;
+
+    lightMap = 0;
+
+    geometryVersion = -1;
+
+    killDaughterNuclei = false;
 
     G4RunManager::GetRunManager()->SetPrintProgress( 1 );
 }
@@ -71,6 +88,9 @@ RunAction::RunAction( CommandlineArguments* c) : G4UserRunAction(), fRunActionMe
 
 RunAction::~RunAction(){
 
+    delete earlyAbort;
+    delete lightMap;
+
     // Moved from EndOfRun so that multiple runs can be recorded in a single file.
     //
     if( outputFile!=0 ) {
@@ -99,17 +119,41 @@ RunAction::~RunAction(){
 
         // New since April 28, 2022
         // Record the material table as well.
+        // Tables are normally taken at the end of each run; this one covers jobs without runs.
+        //
+        if( metadata.find( "geometryTable" )==metadata.end() ){
+            metadata["geometryTable"] = GetGeometryTable();
+        }
+
+        GeometryManager::Get()->SaveMassCache();
+
+        // The exported world lets analysis look up volumes (e.g. with TGeoManager::Import) without Geant4.
         //
-        TMacro geomTable( "geometryTable");
-
-        // Iterate over the vector of stored physical volumes and get their material & mass.
-        auto volumeStore = G4PhysicalVolumeStore::GetInstance();
-        for( auto itr = volumeStore->begin(); itr!=volumeStore->end(); itr++){
-            ss.str( std::string() ); // clear the string stream
-            ss << (*itr)->GetName() << ' ' << (*itr)->GetLogicalVolume()->GetMass( false, false )/CLHEP::kg << ' ' << (*itr)->GetLogicalVolume()->GetMaterial()->GetName();
-            geomTable.AddLine( ss.str().c_str() );
+        if( GeometryManager::Get()->GetGDMLFile()!="" ){
+            TMacro gdml( "geometryGDML" );
+            gdml.ReadFile( GeometryManager::Get()->GetGDMLFile().c_str() );
+            gdml.Write();
+        }
+
+        // Source configuration registered by other classes.
+        //
+        for( auto itr = metadata.begin(); itr!=metadata.end(); itr++ ){
+            TMacro mac( itr->first.c_str() );
+            for( size_t i=0; i<itr->second.size(); i++ ){
+                mac.AddLine( itr->second[i].c_str() );
+            }
+            mac.Write();
+        }
+
+        if( !counters.empty() ){
+            TMacro mac( "counters" );
+            for( auto itr = counters.begin(); itr!=counters.end(); itr++ ){
+                ss.str( std::string() );
+                ss << itr->first << ' ' << itr->second;
+                mac.AddLine( ss.str().c_str() );
+            }
+            mac.Write();
         }
-        geomTable.Write();
 
         outputFile->Write();
         outputFile->Close();
@@ -129,6 +173,10 @@ void RunAction::SetOutputFileName( G4String newname ){
 
 void RunAction::BeginOfRunAction(const G4Run* /*run*/){
 
+    // Physics tables have been built at this point.
+    //
+    PhysicsTableCache::Get()->Store();
+
     // If output name is specified, create a ROOT file and a TTree.
     //
     if( outputName!="" && outputFile==0 ){
@@ -141,11 +189,115 @@ void RunAction::BeginOfRunAction(const G4Run* /*run*/){
             G4cout << "TTree object created." << G4endl;
         }
     }
+
+    // Phase-space tree is created only when a recording boundary is specified.
+    //
+    if( outputFile!=0 && outputFile->IsOpen() && phaseSpaceTree==0 && !phaseSpaceVolume.empty() ){
+        outputFile->cd();
+        phaseSpaceTree = new TTree("phaseSpace", "Particles entering the phase-space volumes");
+        phaseSpaceRecord.Branch( phaseSpaceTree );
+        G4cout << "Phase-space TTree object created." << G4endl;
+    }
+
+    // Targets of early abort and range kill are the recordWhenHit volumes.
+    //
+    recordBoxes.SetVolumes( recordWhenHit );
+
+    if( earlyAbort!=0 ){
+        if( recordWhenHit.empty() ){
+            G4cout << GetClassName() << ": no recordWhenHit volume, early abort has no effect." << G4endl;
+        }
+        earlyAbort->SetTargets( &recordBoxes );
+    }
+
+    if( !rangeKillVolume.empty() && recordWhenHit.empty() ){
+        G4cout << GetClassName() << ": no recordWhenHit volume, range kill has no effect." << G4endl;
+    }
+
+    // Adjoint tree is created once since the score array is bound to the branch.
+    //
+    if( outputFile!=0 && outputFile->IsOpen() && adjointTree==0 && adjointScorer!=0 ){
+        outputFile->cd();
+        adjointScorer->Configure();
+        adjointTree = new TTree("adjoint", "Adjoint flux scores in source materials");
+        adjointScorer->Branch( adjointTree );
+        SetMetadata( "adjoint", adjointScorer->GetSummary() );
+        G4cout << "Adjoint TTree object created." << G4endl;
+    }
+
+    // Photoelectrons are computed from the light collection map when it is given in the geometry config.
+    //
+    if( lightMap==0 && GeometryManager::Get()->GetConfigParser()->Find( "/optical/map" ) ){
+        lightMap = new LightCollectionMap();
+    }
+
+    if( lightMap!=0 ){
+        lightMap->Configure();
+    }
 }
 
 
 
-void RunAction::EndOfRunAction( const G4Run* ){}
+void RunAction::EndOfRunAction( const G4Run* run ){
+
+    // Runs of a sweep share the output file and are identified by the runID branch.
+    //
+    std::vector<G4String>& runs = metadata["runs"];
+    if( runs.empty() ){
+        runs.push_back( "# runID nEvents tag" );
+    }
+    std::stringstream ss;
+    ss << run->GetRunID() << ' ' << run->GetNumberOfEvent() << ' ' << runTag;
+    runs.push_back( ss.str() );
+
+    // Material and mass of each volume, for normalization.
+    // In a sweep, the first geometry is in geometryTable and runs after a geometry change get geometryTable_run<runID>.
+    //
+    if( GeometryManager::Get()->GetGeometryVersion()!=geometryVersion ){
+        geometryVersion = GeometryManager::Get()->GetGeometryVersion();
+        G4String name = metadata.find( "geometryTable" )==metadata.end() ? G4String( "geometryTable" ) : G4String( "geometryTable_run" + std::to_string( run->GetRunID() ) );
+        SetMetadata( name, GetGeometryTable() );
+    }
+
+    // Navigation cost per volume, accumulated over all runs so far.
+    //
+    if( NavigationProfiler::Get()!=0 ){
+        std::vector<G4String> report = NavigationProfiler::Get()->GetReport();
+        G4cout << GetClassName() << ": navigation per volume\n";
+        for( size_t i=0; i<report.size() && i<21; i++ ){
+            G4cout << "    " << report[i] << '\n';
+        }
+        G4cout << G4endl;
+        SetMetadata( "navigation", report );
+    }
+
+    // The light collection map is written after each run, including the photons of earlier runs.
+    //
+    if( lightMap!=0 ){
+        if( lightMap->IsGenerating() ){
+            lightMap->Save();
+        }
+        SetMetadata( "opticalMap", lightMap->GetSummary() );
+    }
+
+    // Stages left when the run ends are not simulated.
+    //
+    if( !stageQueue.empty() ){
+        G4cout << GetClassName() << ": " << stageQueue.size() << " split decay stages not simulated at the end of run." << G4endl;
+        AddCount( "splitStagesDropped", stageQueue.size() );
+        stageQueue.clear();
+    }
+}
+
+
+bool RunAction::PopStage( DeferredStage& a ){
+    if( stageQueue.empty() ){
+        return false;
+    }
+    a = stageQueue.front();
+    stageQueue.pop_front();
+    return true;
+}
 
 
 
@@ -154,6 +306,42 @@ TTree* RunAction::GetDataTree(){
 }
 
 
+TTree* RunAction::GetPhaseSpaceTree(){
+    return phaseSpaceTree;
+}
+
+
+void RunAction::FillPhaseSpace( const G4Step* step ){
+    if( phaseSpaceTree!=0 ){
+        phaseSpaceRecord.Fill( step );
+        phaseSpaceTree->Fill();
+    }
+}
+
+
+std::vector<G4String> RunAction::GetGeometryTable(){
+
+    std::vector<G4String> table;
+
+    // Iterate over the vector of stored physical volumes and get their material & mass.
+    // The mass includes all copies of replicas, parameterised volumes and daughters of repeated mothers.
+    auto volumeStore = G4PhysicalVolumeStore::GetInstance();
+    for( auto itr = volumeStore->begin(); itr!=volumeStore->end(); itr++){
+        std::stringstream ss;
+        size_t copies = std::max( (size_t)1, GeometryManager::GetNumberOfInstances( *itr ) );
+        ss << (*itr)->GetName() << ' ' << copies * GeometryManager::Get()->GetMass( (*itr)->GetLogicalVolume() )/CLHEP::kg << ' ' << (*itr)->GetLogicalVolume()->GetMaterial()->GetName();
+        table.push_back( ss.str() );
+    }
+
+    return table;
+}
+
+
+void RunAction::SetMetadata( G4String name, std::vector<G4String> lines ){
+    metadata[name] = lines;
+}
+
+
 void RunAction::AddRecordWhenHit( G4String a){ recordWhenHit.insert(a); }
 
 
@@ -168,6 +356,24 @@ bool RunAction::RecordWhenHit( G4String a ){
 }
 
 
+void RunAction::SetEarlyAbort( bool a ){
+    if( a==true && earlyAbort==0 ){
+        earlyAbort = new EarlyAbort();
+    }
+    else if( a==false && earlyAbort!=0 ){
+        delete earlyAbort;
+        earlyAbort = 0;
+    }
+}
+
+
+void RunAction::AddRangeKillVolume( G4String a){ rangeKillVolume.insert(a); }
+
+bool RunAction::RangeKillVolume( G4String a ){
+    return rangeKillVolume.find( a ) != rangeKillVolume.end();
+}
+
+
 void RunAction::AddKillWhenHit( G4String a){ killWhenHit.insert(a); }
 
 bool RunAction::KillWhenHit( G4String a ){
@@ -202,3 +408,10 @@ void RunAction::AddExcludeProcess( G4String a){ excludeProcess.insert(a); }
 bool RunAction::ExcludeProcess( G4String a ){
     return excludeProcess.find( a ) != excludeProcess.end();
 }
+
+
+void RunAction::AddPhaseSpaceVolume( G4String a){ phaseSpaceVolume.insert(a); }
+
+bool RunAction::PhaseSpaceVolume( G4String a ){
+    return phaseSpaceVolume.find( a ) != phaseSpaceVolume.end();
+}
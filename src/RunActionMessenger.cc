@@ -12,6 +12,7 @@
 
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
 #include "G4UIdirectory.hh"
 
 
@@ -51,6 +52,32 @@ RunActionMessenger::RunActionMessenger( RunAction* EvAct ) : G4UImessenger(),fRu
     fCmdExcludeProcess->SetGuidance( "Ignore steps defined by the process." );
     fCmdExcludeProcess->SetParameterName( "ProcessName", false );
     fCmdExcludeProcess->AvailableForStates(G4State_Idle);
+
+    fCmdEarlyAbort = new G4UIcmdWithABool( (dir+"earlyAbort").c_str(), this );
+    fCmdEarlyAbort->SetGuidance( "Abort the event when no track can reach a recordWhenHit volume." );
+    fCmdEarlyAbort->SetGuidance( "Charged particles are judged by range and distance. Aborted events are counted as earlyAborted." );
+    fCmdEarlyAbort->SetParameterName( "abort", false );
+    fCmdEarlyAbort->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fCmdRangeKill = new G4UIcmdWithAString( (dir+"rangeKill").c_str(), this );
+    fCmdRangeKill->SetGuidance( "Kill charged particles in the volume whose range is shorter than the distance to any recordWhenHit volume." );
+    fCmdRangeKill->SetGuidance( "The kinetic energy is deposited at the point of the kill." );
+    fCmdRangeKill->SetParameterName( "VolumeName", false );
+    fCmdRangeKill->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fCmdRunTag = new G4UIcmdWithAString( "/run/tag", this );
+    fCmdRunTag->SetGuidance( "Label of the following runs, written with the run ID and number of events to the runs macro." );
+    fCmdRunTag->SetGuidance( "Used to identify the points of a parameter sweep in a single output file." );
+    fCmdRunTag->SetParameterName( "tag", false );
+    fCmdRunTag->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fPhaseSpaceDir = new G4UIdirectory("/phaseSpace/");
+    fPhaseSpaceDir->SetGuidance("Record particles crossing a boundary for later replay with /generator/phaseSpace.");
+
+    fCmdPhaseSpace = new G4UIcmdWithAString( "/phaseSpace/recordAt", this );
+    fCmdPhaseSpace->SetGuidance( "Record particles entering the specified volume into the phaseSpace tree." );
+    fCmdPhaseSpace->SetParameterName( "VolumeName", false );
+    fCmdPhaseSpace->AvailableForStates(G4State_PreInit, G4State_Idle);
 }
 
 
@@ -63,6 +90,12 @@ RunActionMessenger::~RunActionMessenger(){
   delete fCmdKillParticle;
   delete fCmdExcludeVolume;
   delete fCmdExcludeProcess;
+
+  delete fCmdEarlyAbort;
+  delete fCmdRangeKill;
+  delete fCmdRunTag;
+  delete fCmdPhaseSpace;
+  delete fPhaseSpaceDir;
 }
 
 
@@ -86,5 +119,17 @@ void RunActionMessenger::SetNewValue(G4UIcommand* command, G4String newValue){
     else if( command==fCmdExcludeProcess ){
         fRunAction->AddExcludeProcess( newValue );
     }
+    else if( command==fCmdEarlyAbort ){
+        fRunAction->SetEarlyAbort( fCmdEarlyAbort->GetNewBoolValue( newValue ) );
+    }
+    else if( command==fCmdRangeKill ){
+        fRunAction->AddRangeKillVolume( newValue );
+    }
+    else if( command==fCmdRunTag ){
+        fRunAction->SetRunTag( newValue );
+    }
+    else if( command==fCmdPhaseSpace ){
+        fRunAction->AddPhaseSpaceVolume( newValue );
+    }
 }
 
@@ -0,0 +1,220 @@
+/// \file SpectrumSampler.cc
+/// \brief Implementation of the SpectrumSampler class
+
+#include "SpectrumSampler.hh"
+
+#include "G4ParticleTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include "TFile.h"
+#include "TKey.h"
+#include "TH1.h"
+#include "TH2.h"
+#include "TH3.h"
+#include "THnBase.h"
+#include "TAxis.h"
+
+#include <cmath>
+
+
+SpectrumSampler::SpectrumSampler(){}
+
+
+bool SpectrumSampler::Load( G4String fileName ){
+
+    components.clear();
+    componentTable.Clear();
+
+    TFile* file = TFile::Open( fileName.c_str(), "READ" );
+    if( file==0 || !file->IsOpen() ){
+        G4cerr << "SpectrumSampler: error opening " << fileName << G4endl;
+        delete file;
+        return false;
+    }
+
+    TIter next( file->GetListOfKeys() );
+    TKey* key;
+    while( (key=(TKey*)next()) ){
+
+        // Keys of older cycles of the same histogram are listed too, and only the latest one is used.
+        //
+        if( key->GetCycle()!=file->GetKey( key->GetName() )->GetCycle() ){
+            continue;
+        }
+
+        TObject* obj = key->ReadObj();
+
+        if( obj->InheritsFrom( TH1::Class() ) ){
+            AddHistogram( (TH1*)obj );
+        }
+        else if( obj->InheritsFrom( THnBase::Class() ) ){
+            AddTHn( (THnBase*)obj );
+        }
+
+        delete obj;
+    }
+
+    file->Close();
+    delete file;
+
+    // Components are sampled in proportion to their integrals.
+    //
+    std::vector<G4double> weights;
+    for( size_t i=0; i<components.size(); i++ ){
+        weights.push_back( components[i].table.GetTotal() );
+    }
+    componentTable.Build( weights );
+
+    if( componentTable.empty() ){
+        G4cerr << "SpectrumSampler: no usable histogram in " << fileName << G4endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+G4String SpectrumSampler::GetParticleName( G4String histName ){
+    if( G4ParticleTable::GetParticleTable()->FindParticle( histName )!=0 ){
+        return histName;
+    }
+    return "";
+}
+
+
+void SpectrumSampler::AddHistogram( TH1* hist ){
+
+    Component component;
+    component.particle = GetParticleName( hist->GetName() );
+    component.dimension = hist->GetDimension();
+
+    std::vector<G4double> weights;
+
+    TAxis* axis[3] = { hist->GetXaxis(), hist->GetYaxis(), hist->GetZaxis() };
+    G4int nbins[3] = { hist->GetNbinsX(), hist->GetNbinsY(), hist->GetNbinsZ() };
+
+    for( G4int ix=1; ix<=nbins[0]; ix++ ){
+        for( G4int iy=1; iy<=nbins[1]; iy++ ){
+            for( G4int iz=1; iz<=nbins[2]; iz++ ){
+
+                G4double content = hist->GetBinContent( ix, iy, iz );
+                if( content<=0 ){
+                    continue;
+                }
+
+                G4int index[3] = { ix, iy, iz };
+                for( G4int d=0; d<3; d++ ){
+                    if( d<component.dimension ){
+                        component.binLow.push_back( axis[d]->GetBinLowEdge( index[d] ) );
+                        component.binWidth.push_back( axis[d]->GetBinWidth( index[d] ) );
+                    }
+                    else{
+                        component.binLow.push_back( 0 );
+                        component.binWidth.push_back( 0 );
+                    }
+                }
+                weights.push_back( content );
+            }
+        }
+    }
+
+    AddComponent( component, weights );
+}
+
+
+void SpectrumSampler::AddTHn( THnBase* hist ){
+
+    Component component;
+    component.particle = GetParticleName( hist->GetName() );
+    component.dimension = hist->GetNdimensions() < 3 ? hist->GetNdimensions() : 3;
+
+    if( hist->GetNdimensions() > 3 ){
+        G4cerr << "SpectrumSampler: " << hist->GetName() << " has more than 3 dimensions. Extra dimensions are ignored." << G4endl;
+    }
+
+    std::vector<G4double> weights;
+    std::vector<Int_t> coord( hist->GetNdimensions() );
+
+    // For THnSparse, this iterates over filled bins only.
+    //
+    for( Long64_t i=0; i<hist->GetNbins(); i++ ){
+
+        G4double content = hist->GetBinContent( i, coord.data() );
+        if( content<=0 ){
+            continue;
+        }
+
+        // Skip under- and overflow bins.
+        //
+        bool inRange = true;
+        for( G4int d=0; d<component.dimension; d++ ){
+            if( coord[d]<1 || coord[d]>hist->GetAxis(d)->GetNbins() ){
+                inRange = false;
+            }
+        }
+        if( !inRange ){
+            continue;
+        }
+
+        for( G4int d=0; d<3; d++ ){
+            if( d<component.dimension ){
+                component.binLow.push_back( hist->GetAxis(d)->GetBinLowEdge( coord[d] ) );
+                component.binWidth.push_back( hist->GetAxis(d)->GetBinWidth( coord[d] ) );
+            }
+            else{
+                component.binLow.push_back( 0 );
+                component.binWidth.push_back( 0 );
+            }
+        }
+        weights.push_back( content );
+    }
+
+    AddComponent( component, weights );
+}
+
+
+void SpectrumSampler::AddComponent( Component& component, const std::vector<G4double>& weights ){
+
+    if( weights.empty() ){
+        return;
+    }
+
+    component.table.Build( weights );
+    components.push_back( component );
+
+    G4cout << "SpectrumSampler: added " << component.dimension << "D spectrum of "
+        << ( component.particle=="" ? "default particle" : component.particle )
+        << " with " << weights.size() << " bins, integral " << component.table.GetTotal() << G4endl;
+}
+
+
+void SpectrumSampler::Sample( G4String& particle, G4double& energy, G4ThreeVector& direction ){
+
+    Component& component = components[ componentTable.Sample() ];
+
+    if( component.particle!="" ){
+        particle = component.particle;
+    }
+
+    size_t bin = component.table.Sample();
+
+    G4double value[3];
+    for( G4int d=0; d<3; d++ ){
+        value[d] = component.binLow[3*bin+d] + G4UniformRand() * component.binWidth[3*bin+d];
+    }
+
+    energy = value[0] * keV;
+
+    G4double theta = value[1];
+    G4double phi = value[2];
+
+    // For 2D spectra (energy vs polar angle), the azimuthal direction is fixed as before.
+    //
+    if( component.dimension==2 ){
+        direction = G4ThreeVector( 0, std::sin(theta), std::cos(theta) );
+    }
+    else{
+        direction = G4ThreeVector( std::sin(theta)*std::cos(phi), std::sin(theta)*std::sin(phi), std::cos(theta) );
+    }
+}
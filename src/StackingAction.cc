@@ -7,24 +7,110 @@
 /// \brief Implementation of the StackingAction class
 
 #include "StackingAction.hh"
+#include "StackingActionMessenger.hh"
 
 #include "G4Track.hh"
 #include "G4VProcess.hh"
 #include "G4StackManager.hh"
+#include "G4Ions.hh"
+#include "G4EventManager.hh"
+#include "G4Event.hh"
+#include "EventInformation.hh"
 
 #include "G4SystemOfUnits.hh"
 
+#include <algorithm>
+
 
 StackingAction::StackingAction( RunAction* runAction, EventAction* eventAction) : 
     fRunAction( runAction ),
-    fEventAction( eventAction ){ }
+    fEventAction( eventAction ),
+    timeWindow( 1*CLHEP::ms ),
+    maxWaiting( 0 ),
+    reclassifying( false ),
+    splitStages( false ),
+    stageStart( 0 ){
+
+    fMessenger = new StackingActionMessenger( this );
+}
+
+
+StackingAction::~StackingAction(){
+    delete fMessenger;
+}
+
 
+void StackingAction::PrepareNewEvent(){
+    deferred.clear();
+    reclassifying = false;
+    stageStart = 0;
 
-StackingAction::~StackingAction(){ }
+    if( fRunAction->GetEarlyAbort()!=0 ){
+        fRunAction->GetEarlyAbort()->BeginOfEvent();
+    }
+}
 
 
+// Every live track is registered for early abort. Deferred tracks removed in split mode are forgotten.
+//
 G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* track){
 
+    G4bool reclassified = reclassifying;
+
+    G4ClassificationOfNewTrack classification = Classify( track );
+
+    EarlyAbort* earlyAbort = fRunAction->GetEarlyAbort();
+    if( earlyAbort!=0 ){
+        if( reclassified==false && classification!=fKill ){
+            earlyAbort->NewTrack( track );
+        }
+        else if( reclassified==true && classification==fKill ){
+            earlyAbort->ForgetTrack( track );
+        }
+    }
+
+    return classification;
+}
+
+
+G4ClassificationOfNewTrack StackingAction::Classify(const G4Track* track){
+
+    // Deferred tracks are reclassified at the beginning of a new stage.
+    // Those produced by the earliest decay are released with time relative to the decay.
+    //
+    if( reclassifying==true ){
+
+        auto itr = deferred.find( track );
+        if( itr==deferred.end() ){
+            return fUrgent;
+        }
+
+        // In split mode, all deferred tracks are copied out and removed from this event.
+        //
+        if( splitStages==true ){
+            DeferredStage::Track copy;
+            copy.definition = track->GetDefinition();
+            copy.position = track->GetPosition();
+            copy.direction = track->GetMomentumDirection();
+            copy.energy = track->GetKineticEnergy();
+            copy.time = 0;
+            copy.weight = track->GetWeight();
+            harvested.push_back( std::make_pair( itr->second, copy ) );
+            deferred.erase( itr );
+            return fKill;
+        }
+
+        // Decay times of long-lived members reach 1e26 ns, where adding the window to stageStart has no effect.
+        // The difference is compared instead.
+        //
+        if( itr->second - stageStart < timeWindow ){
+            const_cast<G4Track*>(track)->SetGlobalTime( itr->second - stageStart );
+            deferred.erase( itr );
+            return fUrgent;
+        }
+        return fWaiting;
+    }
+
     // By default, ignore or do not track neutrinos
     //
     G4String particleName = track->GetDefinition()->GetParticleName();
@@ -32,38 +118,137 @@ G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* track
         return fKill;
     }
 
-    // If global time is within the window, return urgent regardless of the process:
+    const G4Ions* ion = dynamic_cast<const G4Ions*>( track->GetDefinition() );
+    G4bool fromDecay = track->GetCreatorProcess()!=0 && track->GetCreatorProcess()->GetProcessName().find("Radioactiv")!=std::string::npos;
+
+    // When chain members are sampled directly by the generator,
+    // ground-state daughter nuclei are sampled as separate events and should not decay here.
+    // Excited daughters are kept so that their de-excitation belongs to the decay producing them.
     //
-    G4double window = 1*CLHEP::ms;
-        // 1-ms window
+    if( fRunAction->KillDaughterNuclei() && fromDecay ){
+        if( ion!=0 && ion->GetBaryonNumber()>4 && ion->GetExcitationEnergy()<=0 ){
+            return fKill;
+        }
+    }
 
+    // Chain segments below the specified nuclei are not simulated.
+    //
+    if( fromDecay && ion!=0 && stopChainAfter.find( track->GetDefinition() )!=stopChainAfter.end() ){
+        return fKill;
+    }
+
+    // If global time is within the window, return urgent regardless of the process:
+    //
     G4double time = track->GetGlobalTime();
-    if( time < window ){
+    if( time < timeWindow ){
         return fUrgent;
     }
 
     // Check if it's a radioactive decay that happened years later.
+    // The process is registered as Radioactivation (or RadioactiveDecay in older versions), see fromDecay above.
     //
-    G4String motherProcess = "";
-    if( track->GetCreatorProcess()!=0 ){
-        motherProcess = track->GetCreatorProcess()->GetProcessName();
-    }
-
-    //G4cout << "Name: " << track->GetParticleDefinition()->GetParticleName() << "\tt: " << track->GetGlobalTime() << "\tCreatorProc: " << motherProcess << G4endl;
-
-    if( motherProcess.find("RadioactiveDecay")==std::string::npos ){
+    if( fromDecay==false ){
         return fUrgent;
     }
     else{
         //G4cout << "Radioactivity out of window detected!" << G4endl;
-        const_cast<G4Track*>(track)->SetGlobalTime(0);
+
+        // Bound the waiting stack. Killed tracks are counted for normalization.
+        //
+        if( maxWaiting>0 && (G4int)deferred.size()>=maxWaiting ){
+            fRunAction->AddCount( "stackingKilled" );
+            return fKill;
+        }
+
+        // Times of tracks released in a stage are relative to the stage start.
+        // Deferred times are kept absolute so that they can be compared with the earlier ones.
+        //
+        deferred[ track ] = time + stageStart;
         return fWaiting;
     }
 }
 
 
 void StackingAction::NewStage(){
+
+    if( deferred.empty() ){
+        return;
+    }
+
+    if( splitStages==true ){
+        SplitStages();
+        return;
+    }
+
+    // Release the earliest deferred decay.
+    //
+    stageStart = deferred.begin()->second;
+    for( auto itr = deferred.begin(); itr!=deferred.end(); itr++ ){
+        stageStart = std::min( stageStart, itr->second );
+    }
+
+    reclassifying = true;
+    stackManager->ReClassify();
+    reclassifying = false;
+
     StepInfo stepinfo;
     stepinfo.SetProcessName( "timeReset" );
     fEventAction->GetStepCollection().push_back(stepinfo);
 }
+
+
+// Group the deferred tracks by decay time and queue each group as a separate event.
+// Nothing is left to be simulated in the current event.
+//
+void StackingAction::SplitStages(){
+
+    harvested.clear();
+
+    reclassifying = true;
+    stackManager->ReClassify();
+    reclassifying = false;
+
+    std::sort( harvested.begin(), harvested.end(),
+        []( const std::pair<G4double, DeferredStage::Track>& a, const std::pair<G4double, DeferredStage::Track>& b ){ return a.first < b.first; } );
+
+    // The stage is linked to the event where the chain started, which may itself be a split stage.
+    //
+    const G4Event* event = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+
+    DeferredStage stage;
+    stage.parentEventID = event->GetEventID();
+    stage.sourceCode = 0;
+    stage.sourceWeight = 1;
+
+    EventInformation* info = dynamic_cast<EventInformation*>( event->GetUserInformation() );
+    if( info!=0 ){
+        stage.sourceCode = info->GetSourceCode();
+        stage.sourceWeight = info->GetSourceWeight();
+        if( info->GetParentEventID()>=0 ){
+            stage.parentEventID = info->GetParentEventID();
+        }
+    }
+
+    size_t i = 0;
+    while( i<harvested.size() ){
+
+        // The first track always opens the stage. Later tracks are compared by difference,
+        // since start + timeWindow equals start at decay times around 1e26 ns.
+        //
+        G4double start = harvested[i].first;
+        stage.tracks.clear();
+
+        harvested[i].second.time = 0;
+        stage.tracks.push_back( harvested[i].second );
+
+        for( i++; i<harvested.size() && harvested[i].first - start < timeWindow; i++ ){
+            harvested[i].second.time = harvested[i].first - start;
+            stage.tracks.push_back( harvested[i].second );
+        }
+
+        fRunAction->PushStage( stage );
+        fRunAction->AddCount( "splitStages" );
+    }
+
+    harvested.clear();
+}
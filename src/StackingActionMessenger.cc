@@ -0,0 +1,78 @@
+/// \file StackingActionMessenger.cc
+/// \brief Implementation of the StackingActionMessenger class
+
+#include "StackingActionMessenger.hh"
+#include "StackingAction.hh"
+#include "DecayChainSampler.hh"
+
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIdirectory.hh"
+
+
+StackingActionMessenger::StackingActionMessenger( StackingAction* stack ) : G4UImessenger(), fStackingAction( stack ){
+
+    G4String dir = "/stacking/";
+
+    fDir = new G4UIdirectory( dir );
+    fDir->SetGuidance( "Scheduling of delayed radioactive decay products." );
+
+    fCmdTimeWindow = new G4UIcmdWithADoubleAndUnit( (dir+"timeWindow").c_str(), this );
+    fCmdTimeWindow->SetGuidance( "Decay products later than this window are simulated in a new stage with time reset." );
+    fCmdTimeWindow->SetParameterName( "window", false );
+    fCmdTimeWindow->SetDefaultUnit( "ms" );
+    fCmdTimeWindow->SetRange( "window>0" );
+    fCmdTimeWindow->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    fCmdMaxWaiting = new G4UIcmdWithAnInteger( (dir+"maxWaiting").c_str(), this );
+    fCmdMaxWaiting->SetGuidance( "Maximum number of deferred decay products per event. Others are killed and counted as stackingKilled." );
+    fCmdMaxWaiting->SetGuidance( "0 for no limit." );
+    fCmdMaxWaiting->SetParameterName( "N", false );
+    fCmdMaxWaiting->SetRange( "N>=0" );
+    fCmdMaxWaiting->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    fCmdStopChainAfter = new G4UIcmdWithAString( (dir+"stopChainAfter").c_str(), this );
+    fCmdStopChainAfter->SetGuidance( "Do not track the ground state of this nucleus when produced by radioactive decay, e.g. Pb210." );
+    fCmdStopChainAfter->SetParameterName( "isotope", false );
+    fCmdStopChainAfter->AvailableForStates( G4State_Idle );
+
+    fCmdSplitStages = new G4UIcmdWithABool( (dir+"splitStages").c_str(), this );
+    fCmdSplitStages->SetGuidance( "Simulate each delayed decay as a separate event linked by parentEventID." );
+    fCmdSplitStages->SetGuidance( "These events use up event slots of /run/beamOn and are counted as splitStages." );
+    fCmdSplitStages->SetGuidance( "Stages still queued when the run ends are dropped and counted as splitStagesDropped." );
+    fCmdSplitStages->SetParameterName( "split", false );
+    fCmdSplitStages->AvailableForStates( G4State_PreInit, G4State_Idle );
+}
+
+
+StackingActionMessenger::~StackingActionMessenger(){
+    delete fCmdTimeWindow;
+    delete fCmdMaxWaiting;
+    delete fCmdStopChainAfter;
+    delete fCmdSplitStages;
+    delete fDir;
+}
+
+
+void StackingActionMessenger::SetNewValue( G4UIcommand* cmd, G4String val ){
+
+    if( cmd == fCmdTimeWindow ){
+        fStackingAction->SetTimeWindow( fCmdTimeWindow->GetNewDoubleValue( val ) );
+    }
+    else if( cmd == fCmdMaxWaiting ){
+        fStackingAction->SetMaxWaiting( fCmdMaxWaiting->GetNewIntValue( val ) );
+    }
+    else if( cmd == fCmdStopChainAfter ){
+        G4ParticleDefinition* ion = DecayChainSampler::GetIon( val );
+        if( ion==0 ){
+            G4cerr << "StackingActionMessenger: cannot interpret isotope " << val << G4endl;
+            return;
+        }
+        fStackingAction->AddStopChainAfter( ion );
+    }
+    else if( cmd == fCmdSplitStages ){
+        fStackingAction->SetSplitStages( fCmdSplitStages->GetNewBoolValue( val ) );
+    }
+}
@@ -31,10 +31,13 @@ StepInfo::StepInfo()
     Eki(0),
     Ekf(0),
     Edep(0),
+    Wi(1),
+    Wf(1),
     position(0),
     momentumDir(0),
     globalTime(0),
-    processName("")
+    processName(""),
+    Npe(0)
 {}
 
 
@@ -49,10 +52,13 @@ StepInfo::StepInfo( const G4Step* step )
     Eki(0),
     Ekf(0),
     Edep(0),
+    Wi(1),
+    Wf(1),
     position(0),
     momentumDir(0),
     globalTime(0),
-    processName("")
+    processName(""),
+    Npe(0)
 {
 
     // From the input step, get necessary pointers to steps and tracks.
@@ -92,6 +98,9 @@ StepInfo::StepInfo( const G4Step* step )
     SetEkf( postStep->GetKineticEnergy() );
     SetEdep( step->GetTotalEnergyDeposit() );
 
+    SetWi( preStep->GetWeight() );
+    SetWf( postStep->GetWeight() );
+
     // If this is a first step in the series, set process name to be a special flag.
     //
     if(!postStep->GetProcessDefinedStep()){
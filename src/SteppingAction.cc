@@ -14,6 +14,8 @@
 #include "G4Neutron.hh"
 #include "G4Step.hh"
 #include "G4RunManager.hh"
+#include "G4LossTableManager.hh"
+#include "G4ProcessManager.hh"
 #include "StepInfo.hh"
 
 
@@ -32,6 +34,22 @@ void SteppingAction::UserSteppingAction( const G4Step* step){
     //
     G4Track* track = step->GetTrack();
 
+    // Keep track of whether the event can still reach a recordWhenHit volume.
+    //
+    if( fRunAction->GetEarlyAbort()!=0 ){
+        fRunAction->GetEarlyAbort()->Step( track, fRunAction->RecordWhenHit( track->GetVolume()->GetName() ) );
+    }
+
+    // Record the particle if it enters a phase-space volume.
+    // This is done before any filtering so that the phase space is complete.
+    //
+    if( step->GetPostStepPoint()->GetStepStatus()==fGeomBoundary ){
+        G4VPhysicalVolume* next = step->GetPostStepPoint()->GetPhysicalVolume();
+        if( next!=0 && fRunAction->PhaseSpaceVolume( next->GetName() ) ){
+            fRunAction->FillPhaseSpace( step );
+        }
+    }
+
     // Check if the particle should be ignored.
     //
     G4String particle = track->GetParticleDefinition()->GetParticleName();
@@ -49,6 +67,11 @@ void SteppingAction::UserSteppingAction( const G4Step* step){
     }
 
 
+    // Charged particles that cannot reach a recorded volume stop here.
+    // Done before recording so that the deposit is part of this step.
+    //
+    RangeKill( step );
+
     // Check if the volume should be ignored.
     //
     G4String vol = track->GetVolume()->GetName();
@@ -70,7 +93,15 @@ void SteppingAction::UserSteppingAction( const G4Step* step){
     }
     */
     
-    fEventAction->GetStepCollection().push_back( StepInfo(step) );
+    StepInfo stepInfo( step );
+
+    // Energy deposits in the crystal are converted to photoelectrons when a light collection map is applied.
+    //
+    if( fRunAction->GetLightCollectionMap()!=0 ){
+        stepInfo.SetNpe( fRunAction->GetLightCollectionMap()->GetPhotoelectrons( step ) );
+    }
+
+    fEventAction->GetStepCollection().push_back( stepInfo );
 
 	// Check kill-when-hit volume. Remove the track at the volume surface.
     G4VPhysicalVolume* pv = track->GetVolume();
@@ -83,3 +114,45 @@ void SteppingAction::UserSteppingAction( const G4Step* step){
 
 }
 
+
+void SteppingAction::RangeKill( const G4Step* step ){
+
+    G4Track* track = step->GetTrack();
+    G4StepPoint* postStep = step->GetPostStepPoint();
+
+    if( track->GetTrackStatus()!=fAlive || track->GetDefinition()->GetPDGCharge()==0 || postStep->GetPhysicalVolume()==0 ){
+        return;
+    }
+
+    if( fRunAction->RangeKillVolume( postStep->GetPhysicalVolume()->GetName() )==false ){
+        return;
+    }
+
+    TargetBoxes* targets = fRunAction->GetRecordBoxes();
+    if( targets->empty() ){
+        return;
+    }
+
+    G4double range = G4LossTableManager::Instance()->GetRange( track->GetDefinition(), track->GetKineticEnergy(), postStep->GetMaterialCutsCouple() );
+    if( range >= targets->Distance( postStep->GetPosition() ) ){
+        return;
+    }
+
+    // Deposit the kinetic energy in this step.
+    // Particles with at-rest processes (e+ annihilation, decay of nuclei) are stopped but not killed.
+    //
+    G4Step* modified = const_cast<G4Step*>( step );
+    modified->AddTotalEnergyDeposit( track->GetKineticEnergy() );
+    postStep->SetKineticEnergy( 0 );
+    track->SetKineticEnergy( 0 );
+
+    G4ProcessManager* manager = track->GetDefinition()->GetProcessManager();
+    if( manager!=0 && manager->GetAtRestProcessVector()->entries()>0 ){
+        track->SetTrackStatus( fStopButAlive );
+    }
+    else{
+        track->SetTrackStatus( fStopAndKill );
+    }
+
+    fRunAction->AddCount( "rangeKilled" );
+}
@@ -0,0 +1,229 @@
+/// \file SurfaceSource.cc
+/// \brief Implementation of the SurfaceSource class
+
+#include "SurfaceSource.hh"
+#include "GeometryManager.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Box.hh"
+#include "G4Tubs.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <sstream>
+#include <cmath>
+
+
+bool SurfaceSource::Set( G4VPhysicalVolume* pv, const std::vector<G4String>& selection ){
+
+    faces.clear();
+    table.Clear();
+
+    if( pv==0 ){
+        return false;
+    }
+
+    volumeName = pv->GetName();
+
+    // Faces are built in the local frame and transformed at the end.
+    //
+    G4ThreeVector origin;
+    G4VSolid* solid = pv->GetLogicalVolume()->GetSolid();
+
+    std::vector<Face> all;
+
+    if( G4Box* box = dynamic_cast<G4Box*>( solid ) ){
+
+        G4double half[3] = { box->GetXHalfLength(), box->GetYHalfLength(), box->GetZHalfLength() };
+        const char* axisName = "xyz";
+
+        for( G4int i=0; i<3; i++ ){
+
+            G4ThreeVector axis, u, v;
+            axis[i] = 1;
+            u[(i+1)%3] = 1;
+            v[(i+2)%3] = 1;
+
+            for( G4int sign=1; sign>=-1; sign-=2 ){
+                Face face;
+                face.name = G4String( sign>0 ? "+" : "-" ) + axisName[i];
+                face.shape = kRectangle;
+                face.centre = origin + sign*half[i]*axis;
+                face.u = u;
+                face.v = v;
+                face.normal = -sign*axis;
+                face.halfU = half[(i+1)%3];
+                face.halfV = half[(i+2)%3];
+                face.rMin = face.rMax = 0;
+                face.area = 4*face.halfU*face.halfV;
+                all.push_back( face );
+            }
+        }
+    }
+    else if( G4Tubs* tubs = dynamic_cast<G4Tubs*>( solid ) ){
+
+        if( tubs->GetInnerRadius() > 0 ){
+            G4cout << "SurfaceSource: inner surface of " << volumeName << " is not a source face." << G4endl;
+        }
+
+        G4double rMin = tubs->GetInnerRadius();
+        G4double rMax = tubs->GetOuterRadius();
+        G4double dz = tubs->GetZHalfLength();
+        G4double sPhi = tubs->GetStartPhiAngle();
+        G4double dPhi = std::min( tubs->GetDeltaPhiAngle(), CLHEP::twopi );
+
+        Face side;
+        side.name = "side";
+        side.shape = kCylinder;
+        side.centre = origin;
+        side.u = G4ThreeVector( 1, 0, 0 );
+        side.v = G4ThreeVector( 0, 0, 1 );
+        side.normal = G4ThreeVector();
+        side.halfU = 0;
+        side.halfV = dz;
+        side.rMin = rMin;
+        side.rMax = rMax;
+        side.phiStart = sPhi;
+        side.phiDelta = dPhi;
+        side.area = dPhi*rMax*2*dz;
+        all.push_back( side );
+
+        for( G4int sign=1; sign>=-1; sign-=2 ){
+            Face face;
+            face.name = sign>0 ? "+z" : "-z";
+            face.shape = kAnnulus;
+            face.centre = origin + G4ThreeVector( 0, 0, sign*dz );
+            face.u = G4ThreeVector( 1, 0, 0 );
+            face.v = G4ThreeVector( 0, 1, 0 );
+            face.normal = G4ThreeVector( 0, 0, -sign );
+            face.halfU = face.halfV = 0;
+            face.rMin = rMin;
+            face.rMax = rMax;
+            face.phiStart = sPhi;
+            face.phiDelta = dPhi;
+            face.area = dPhi/2*( rMax*rMax - rMin*rMin );
+            all.push_back( face );
+        }
+
+        // A segment is also entered through its two cut planes, whose inward normals point towards the inside of the segment.
+        //
+        if( dPhi < CLHEP::twopi ){
+            for( G4int end=0; end<2; end++ ){
+                G4double phi = sPhi + end*dPhi;
+                G4ThreeVector radial( std::cos(phi), std::sin(phi), 0 );
+                Face face;
+                face.name = end==0 ? "phiStart" : "phiEnd";
+                face.shape = kRectangle;
+                face.centre = origin + ( rMin+rMax )/2*radial;
+                face.u = radial;
+                face.v = G4ThreeVector( 0, 0, 1 );
+                face.normal = ( end==0 ? 1 : -1 )*G4ThreeVector( -std::sin(phi), std::cos(phi), 0 );
+                face.halfU = ( rMax-rMin )/2;
+                face.halfV = dz;
+                face.rMin = face.rMax = 0;
+                face.area = 4*face.halfU*face.halfV;
+                all.push_back( face );
+            }
+        }
+    }
+    else{
+        G4cerr << "SurfaceSource: " << volumeName << " is neither G4Box nor G4Tubs." << G4endl;
+        return false;
+    }
+
+    // Keep the selected faces.
+    //
+    bool useAll = selection.empty() || std::find( selection.begin(), selection.end(), "all" )!=selection.end();
+
+    for( size_t i=0; i<selection.size(); i++ ){
+        bool found = selection[i]=="all";
+        for( size_t j=0; j<all.size(); j++ ){
+            found = found || all[j].name==selection[i];
+        }
+        if( found==false ){
+            G4cerr << "SurfaceSource: " << volumeName << " has no face " << selection[i] << G4endl;
+            return false;
+        }
+    }
+
+    G4AffineTransform transform = GeometryManager::GetGlobalTransform( pv );
+
+    std::vector<G4double> area;
+    for( size_t j=0; j<all.size(); j++ ){
+        if( useAll || std::find( selection.begin(), selection.end(), all[j].name )!=selection.end() ){
+            Face face = all[j];
+            face.centre = transform.TransformPoint( face.centre );
+            face.u = transform.TransformAxis( face.u );
+            face.v = transform.TransformAxis( face.v );
+            face.normal = transform.TransformAxis( face.normal );
+            faces.push_back( face );
+            area.push_back( all[j].area/m2 );
+        }
+    }
+
+    table.Build( area );
+
+    return !table.empty();
+}
+
+
+void SurfaceSource::Sample( G4ThreeVector& position, G4ThreeVector& direction ){
+
+    const Face& face = faces[ table.Sample() ];
+
+    if( face.shape==kRectangle ){
+        position = face.centre + ( 2*G4UniformRand()-1 )*face.halfU*face.u + ( 2*G4UniformRand()-1 )*face.halfV*face.v;
+        direction = SampleCosineLaw( face.normal );
+    }
+    else if( face.shape==kAnnulus ){
+        G4double r = std::sqrt( face.rMin*face.rMin + G4UniformRand()*( face.rMax*face.rMax - face.rMin*face.rMin ) );
+        G4double phi = face.phiStart + face.phiDelta*G4UniformRand();
+        position = face.centre + r*std::cos(phi)*face.u + r*std::sin(phi)*face.v;
+        direction = SampleCosineLaw( face.normal );
+    }
+    else{
+        G4double phi = face.phiStart + face.phiDelta*G4UniformRand();
+        G4ThreeVector radial = std::cos(phi)*face.u + std::sin(phi)*face.v.cross( face.u );
+        position = face.centre + face.rMax*radial + ( 2*G4UniformRand()-1 )*face.halfV*face.v;
+        direction = SampleCosineLaw( -radial );
+    }
+}
+
+
+// Polar angle about the normal follows dN/dcos = 2cos, i.e. cos = sqrt(u).
+//
+G4ThreeVector SurfaceSource::SampleCosineLaw( const G4ThreeVector& normal ){
+
+    G4double cosTheta = std::sqrt( G4UniformRand() );
+    G4double sinTheta = std::sqrt( 1 - cosTheta*cosTheta );
+    G4double phi = CLHEP::twopi*G4UniformRand();
+
+    G4ThreeVector t1 = normal.orthogonal().unit();
+    G4ThreeVector t2 = normal.cross( t1 );
+
+    return cosTheta*normal + sinTheta*( std::cos(phi)*t1 + std::sin(phi)*t2 );
+}
+
+
+std::vector<G4String> SurfaceSource::GetSummary(){
+
+    std::vector<G4String> summary;
+
+    std::stringstream ss;
+    ss << "volume " << volumeName;
+    summary.push_back( ss.str() );
+
+    ss.str("");
+    ss << "area " << GetArea();
+    summary.push_back( ss.str() );
+
+    for( size_t i=0; i<faces.size(); i++ ){
+        ss.str("");
+        ss << "face " << faces[i].name << ' ' << faces[i].area/m2;
+        summary.push_back( ss.str() );
+    }
+
+    return summary;
+}
@@ -0,0 +1,71 @@
+/// \file TargetBoxes.cc
+/// \brief Implementation of the TargetBoxes class
+
+#include "TargetBoxes.hh"
+#include "GeometryManager.hh"
+
+#include "G4PhysicalVolumeStore.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VisExtent.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+void TargetBoxes::SetVolumes( const std::set<G4String>& volumes ){
+    names = volumes;
+    built = false;
+}
+
+
+void TargetBoxes::Build(){
+
+    boxMin.clear();
+    boxMax.clear();
+
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    for( auto itr = store->begin(); itr!=store->end(); itr++ ){
+
+        if( names.find( (*itr)->GetName() )==names.end() ){
+            continue;
+        }
+
+        for( size_t i=0; i<GeometryManager::GetNumberOfInstances( *itr ); i++ ){
+            G4VisExtent extent = GeometryManager::GetGlobalExtent( *itr, i );
+            boxMin.push_back( G4ThreeVector( extent.GetXmin(), extent.GetYmin(), extent.GetZmin() ) );
+            boxMax.push_back( G4ThreeVector( extent.GetXmax(), extent.GetYmax(), extent.GetZmax() ) );
+        }
+    }
+
+    built = true;
+}
+
+
+bool TargetBoxes::empty(){
+    if( built==false ){
+        Build();
+    }
+    return boxMin.empty();
+}
+
+
+G4double TargetBoxes::Distance( const G4ThreeVector& position ){
+
+    if( built==false ){
+        Build();
+    }
+
+    G4double distance = DBL_MAX;
+
+    for( size_t i=0; i<boxMin.size(); i++ ){
+        G4double d2 = 0;
+        for( G4int j=0; j<3; j++ ){
+            G4double d = std::max( std::max( boxMin[i][j]-position[j], position[j]-boxMax[i][j] ), 0. );
+            d2 += d*d;
+        }
+        distance = std::min( distance, std::sqrt( d2 ) );
+    }
+
+    return distance;
+}
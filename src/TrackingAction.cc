@@ -15,6 +15,9 @@
 #include "G4RunManager.hh"
 #include "G4Track.hh"
 #include "G4Step.hh"
+#include "G4TrackingManager.hh"
+#include "G4EventManager.hh"
+#include "G4StackManager.hh"
 
 #include "StepInfo.hh"
 
@@ -64,8 +67,33 @@ void TrackingAction::PreUserTrackingAction(const G4Track* track){
     stepInfo.SetEki( track->GetKineticEnergy() );
     stepInfo.SetEkf( track->GetKineticEnergy() );
 
+    stepInfo.SetWi( track->GetWeight() );
+    stepInfo.SetWf( track->GetWeight() );
+
     stepInfo.SetProcessName( procName );
 
     fEventAction->GetStepCollection().push_back(stepInfo);
 }
 
+
+
+void TrackingAction::PostUserTrackingAction(const G4Track* track){
+
+    EarlyAbort* earlyAbort = fRunAction->GetEarlyAbort();
+    if( earlyAbort==0 ){
+        return;
+    }
+
+    G4TrackVector* secondaries = fpTrackingManager->GimmeSecondaries();
+    if( earlyAbort->EndOfTrack( track, secondaries )==false ){
+        return;
+    }
+
+    // Abort only if something is left to be tracked, so that the counter reflects saved work.
+    //
+    G4bool remaining = G4EventManager::GetEventManager()->GetStackManager()->GetNTotalTrack()>0;
+    if( remaining || ( secondaries!=0 && !secondaries->empty() ) ){
+        fRunAction->AddCount( "earlyAborted" );
+        G4RunManager::GetRunManager()->AbortEvent();
+    }
+}
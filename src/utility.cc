@@ -5,6 +5,10 @@
 */
 #include "utility.hh"
 
+#include <sstream>
+#include <iomanip>
+#include <cstdint>
+
 
 string IsKey( string s){
     
@@ -128,3 +132,17 @@ void CommandlineArguments::Insert( string s, string v){
         std::cerr << "Key " << s << " already exists. Not inserted.\n";
     }
 }
+
+
+string HashString( const string& s ){
+
+    uint64_t hash = 14695981039346656037ULL;
+    for( size_t i=0; i<s.size(); i++ ){
+        hash ^= (unsigned char)s[i];
+        hash *= 1099511628211ULL;
+    }
+
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return ss.str();
+}